@@ -10,15 +10,38 @@ Prerequisites:
 """
 
 import argparse
+import array
 import base64
+import bisect
+import concurrent.futures
+import contextlib
 import csv
-from datetime import datetime
+from datetime import date, datetime, timedelta
+import functools
+import gzip
+import hashlib
+import heapq
 import html
+import http.server
+import io
+import itertools
 import json
+import math
+import mmap
 import os
+import queue
+import random
+import re
+import signal
+import sqlite3
+import struct
 import sys
+import tempfile
+import threading
 import time
 import urllib.parse
+import zipfile
+import zlib
 
 try:
     import requests
@@ -26,334 +49,3574 @@ try:
 except ImportError:
     HAS_REQUESTS = False
 
+try:
+    import fcntl
+except ImportError:
+    fcntl = None
+    import msvcrt
+
+try:
+    import orjson
+    _json_loads = orjson.loads
+    HAS_ORJSON = True
+except ImportError:
+    _json_loads = json.loads
+    HAS_ORJSON = False
+
+try:
+    import ijson
+    HAS_IJSON = True
+    _JSON_ERRORS = (ValueError, ijson.JSONError)
+except ImportError:
+    HAS_IJSON = False
+    _JSON_ERRORS = (ValueError,)
+
+try:
+    import numpy
+    HAS_NUMPY = True
+except ImportError:
+    HAS_NUMPY = False
+
+try:
+    import zstandard
+    HAS_ZSTANDARD = True
+except ImportError:
+    HAS_ZSTANDARD = False
+
+try:
+    import pyarrow
+    import pyarrow.parquet
+    HAS_PYARROW = True
+except ImportError:
+    HAS_PYARROW = False
+
 API_BASE_URL = "https://analytics.dugganusa.com/api/v1/search"
 PDF_BASE_URL = "https://www.justice.gov/epstein/files/"
 API_KEY_PATH = os.path.join(os.getcwd(), ".epstein_api_key")
 CACHE_PATH = os.path.join(os.getcwd(), ".epstein_cache.json")
+CHECKPOINT_PATH = os.path.join(os.getcwd(), ".epstein_checkpoint.json")
+CHECKPOINT_CURSOR_PATH = CHECKPOINT_PATH + ".cursor"
+SCHEDULE_PATH = os.path.join(os.getcwd(), ".epstein_schedule.json")
+HISTORY_PATH = os.path.join(os.getcwd(), ".epstein_history.jsonl")
+HITS_DICT_PATH = os.path.join(os.getcwd(), ".epstein_hits-{}.dict")
+
+# Cached results are considered fresh for this long
+CACHE_TTL_HOURS = 23
+
+# Days of per-day quota usage kept in the schedule file
+SCHEDULE_HISTORY_DAYS = 30
+
+# Only these hit fields are kept; `content` is truncated to what the report
+# shows and dropped entirely when a `content_preview` is present.
+HIT_FIELDS = ('content_preview', 'content', 'file_path', 'doj_url')
+HIT_CONTENT_CHARS = 500
+
+# Cached hits are stored compressed as 'hits_z': "<dictionary id>:<base64>".
+# The dictionary is trained on the cache's own hits once it has
+# HITS_DICT_MIN_ENTRIES contacts with hits, from up to HITS_DICT_SAMPLE_BYTES
+# of them, and saved as HITS_DICT_PATH named by its id. zstandard
+# dictionaries are used when it is installed, zlib preset dictionaries
+# (at most 32 KB) otherwise.
+HITS_DICT_MIN_ENTRIES = 100
+HITS_DICT_SAMPLE_BYTES = 1 << 20
+HITS_ZLIB_DICT_SIZE = 32 * 1024
+HITS_ZSTD_DICT_SIZE = 112 * 1024
+HITS_ZSTD_LEVEL = 15
+
+# Responses at least this large (or of unknown length) are parsed
+# incrementally when ijson is installed, instead of being decoded whole.
+STREAMING_PARSE_MIN_BYTES = 1 << 20
+
+# Local corpus file layout (see build_corpus): a fixed header, the UTF-8
+# text of every document followed by a CORPUS_SEPARATOR byte, a table of
+# document start offsets and a JSON list of document ids. The separator
+# keeps phrase matches from running across documents.
+CORPUS_MAGIC = b'EPSTCORP'
+CORPUS_VERSION = 2
+CORPUS_SEPARATOR = b'\0'
+CORPUS_HEADER = struct.Struct('<8sIIQQQ')  # magic, version, doc count, text/offsets/ids positions
+CORPUS_MAX_HITS = 50
+CORPUS_SNIPPET_CHARS = 250
+
+# Suffix array over a corpus (<corpus>.sa). Suffixes are ordered by their
+# first SA_KEY_BYTES lower-cased bytes, which is exact for patterns up to
+# that length; longer patterns are verified against the text. The array is
+# sorted in runs of SA_RUN_SIZE positions that are then merged, at most
+# SA_MERGE_FAN_IN runs (and open files) at a time, bounding memory during
+# the build.
+SA_MAGIC = b'EPSTSA01'
+SA_HEADER = struct.Struct('<8sQQII')  # magic, corpus size, corpus mtime_ns, key bytes, item size
+SA_KEY_BYTES = 64
+SA_RUN_SIZE = 1 << 18
+SA_MERGE_FAN_IN = 64
+
+# Token store over a corpus (<corpus>.tok): every document tokenized once
+# into lower-cased word ids, stored as a flat uint32 array with per-document
+# token offsets and the term list. Contacts are matched against it in
+# chunks of BIGRAM_CHUNK_TOKENS token pairs.
+TOKEN_MAGIC = b'EPSTTOK1'
+TOKEN_HEADER = struct.Struct('<8sQQQQQ')  # magic, corpus size, corpus mtime_ns, tokens, docs, terms position
+BIGRAM_CHUNK_TOKENS = 1 << 24
+
+# Compiled contact matcher (<corpus>.match), reused while the contact set
+# and token store are unchanged.
+MATCHER_MAGIC = b'EPSTMAT1'
+MATCHER_HEADER = struct.Struct('<8sQQ32sQQ')  # magic, corpus size, corpus mtime_ns, contact set sha256, entries, names position
+
+# Near-duplicate detection: hits are sketched with MinHash over word shingles
+# and bucketed with LSH (bands x rows = permutations). Candidate pairs are
+# merged when their estimated Jaccard similarity reaches the threshold.
+MINHASH_PERMUTATIONS = 64
+MINHASH_BANDS = 16
+MINHASH_SHINGLE_WORDS = 3
+NEAR_DUPLICATE_THRESHOLD = 0.8
+# Each shingle is hashed once to 64 bits; the permutations are that hash
+# XORed with a fixed set of random masks.
+_minhash_rng = random.Random(0x45505354)
+_MINHASH_MASKS = [_minhash_rng.getrandbits(64) for _ in range(MINHASH_PERMUTATIONS)]
+if HAS_NUMPY:
+    _MINHASH_MASK_ARRAY = numpy.array(_MINHASH_MASKS, dtype=numpy.uint64)[:, None]
+
+# Rows are written to exports in batches of this size to bound memory use.
+EXPORT_BATCH_SIZE = 1000
+
+# Report stylesheet; embedded minified (see REPORT_CSS_MIN).
+REPORT_CSS = """
+* {
+    box-sizing: border-box;
+}
+body {
+    font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, Oxygen, Ubuntu, sans-serif;
+    line-height: 1.6;
+    max-width: 1200px;
+    margin: 0 auto;
+    padding: 20px;
+    background-color: #f5f5f5;
+}
+.logo {
+    display: block;
+    max-width: 300px;
+    margin: 0 auto 20px auto;
+}
+.summary {
+    background: #fff;
+    padding: 20px;
+    border-radius: 8px;
+    margin-bottom: 30px;
+    box-shadow: 0 2px 4px rgba(0,0,0,0.1);
+}
+.contact {
+    background: #fff;
+    padding: 20px;
+    margin-bottom: 20px;
+    border-radius: 8px;
+    box-shadow: 0 2px 4px rgba(0,0,0,0.1);
+}
+.contact-header {
+    display: flex;
+    justify-content: space-between;
+    align-items: center;
+    border-bottom: 1px solid #eee;
+    padding-bottom: 10px;
+    margin-bottom: 15px;
+}
+.contact-name {
+    font-size: 1.4em;
+    font-weight: bold;
+    color: #333;
+}
+.contact-info {
+    color: #666;
+    font-size: 0.9em;
+}
+.history {
+    color: #999;
+    font-size: 0.8em;
+}
+.sparkline {
+    vertical-align: middle;
+    margin-left: 5px;
+}
+.sparkline polyline {
+    fill: none;
+    stroke: #e74c3c;
+    stroke-width: 1.5;
+}
+.hit-count {
+    background: #e74c3c;
+    color: white;
+    padding: 5px 15px;
+    border-radius: 20px;
+    font-weight: bold;
+}
+.hit {
+    background: #f9f9f9;
+    padding: 15px;
+    margin-bottom: 10px;
+    border-radius: 4px;
+    border-left: 3px solid #3498db;
+}
+.hit-preview {
+    color: #444;
+    margin-bottom: 10px;
+    font-size: 0.95em;
+}
+.hit-link {
+    display: inline-block;
+    color: #3498db;
+    text-decoration: none;
+    font-size: 0.85em;
+}
+.hit-link:hover {
+    text-decoration: underline;
+}
+.similar {
+    margin: -5px 0 10px 18px;
+    color: #666;
+    font-size: 0.9em;
+}
+.similar summary {
+    cursor: pointer;
+    margin-bottom: 10px;
+}
+.watchlist {
+    background: #fff8e1;
+    border-left: 4px solid #f39c12;
+    padding: 15px 20px;
+    border-radius: 8px;
+    margin-bottom: 30px;
+}
+.watchlist ul {
+    margin: 5px 0 0 0;
+}
+.no-results {
+    color: #999;
+    font-style: italic;
+}
+.footer {
+    margin-top: 40px;
+    padding-top: 20px;
+    border-top: 1px solid #ddd;
+    text-align: center;
+    color: #666;
+    font-size: 0.9em;
+}
+.footer a {
+    color: #3498db;
+    text-decoration: none;
+}
+.footer a:hover {
+    text-decoration: underline;
+}
+"""
+
+# Cards are clustered and rendered in worker processes in chunks of this many
+# contacts once a report's cached hits take at least PARALLEL_RENDER_MIN_BYTES
+# compressed; smaller reports render faster in-process than it takes to start
+# the pool.
+RENDER_CHUNK_SIZE = 200
+PARALLEL_RENDER_MIN_BYTES = 512 * 1024
+
+# Other files of a full LinkedIn data archive that name people, in the order
+# they're read: (source tag, file name, header columns, fields), where each
+# field maps _archive_contact arguments to the columns holding them. The
+# plural full_names and urls name columns holding comma-separated lists,
+# one entry per person.
+ARCHIVE_SOURCES = [
+    ('messages', 'messages.csv', ('FROM', 'TO'), [
+        {'full_name': 'FROM', 'url': 'SENDER PROFILE URL'},
+        {'full_names': 'TO', 'urls': 'RECIPIENT PROFILE URLS'},
+    ]),
+    ('invitations', 'Invitations.csv', ('From', 'To'), [
+        {'full_name': 'From', 'url': 'inviterProfileUrl'},
+        {'full_name': 'To', 'url': 'inviteeProfileUrl'},
+    ]),
+    ('imported_contacts', 'ImportedContacts.csv', ('FirstName', 'LastName'), [
+        {'first_name': 'FirstName', 'last_name': 'LastName', 'company': 'Companies', 'position': 'Title'},
+    ]),
+    ('endorsements', 'Endorsement_Received_Info.csv', ('Endorser First Name', 'Endorser Last Name'), [
+        {'first_name': 'Endorser First Name', 'last_name': 'Endorser Last Name', 'url': 'Endorser Public Url'},
+    ]),
+    ('endorsements', 'Endorsement_Given_Info.csv', ('Endorsee First Name', 'Endorsee Last Name'), [
+        {'first_name': 'Endorsee First Name', 'last_name': 'Endorsee Last Name', 'url': 'Endorsee Public Url'},
+    ]),
+]
+ARCHIVE_PLACEHOLDER_NAMES = {'LinkedIn Member'}
+
+# Connections files of at least PARALLEL_PARSE_MIN_BYTES are parsed by worker
+# processes, split into PARSE_CHUNKS_PER_WORKER byte ranges per worker so a
+# slow chunk doesn't hold up the rest.
+PARALLEL_PARSE_MIN_BYTES = 32 * 1024 * 1024
+PARSE_CHUNKS_PER_WORKER = 4
+
+# Columns appended to the connections CSV by --annotate
+ANNOTATION_COLUMNS = ['Epstein Mentions', 'Top Document URL', 'Last Searched']
+
+# --serve: cards per page by default and at most, and how many rendered
+# responses and clustered contacts are kept until the cache file changes.
+SERVE_PAGE_SIZE = 50
+SERVE_MAX_PAGE_SIZE = 500
+SERVE_RESPONSE_CACHE_SIZE = 256
+SERVE_RESULT_CACHE_SIZE = 5000
+
+# --queue: how long a worker's lease on a job lasts without a heartbeat, how
+# many times a job is tried, and how often an idle worker checks whether a
+# job held by another worker has expired.
+QUEUE_LEASE_SECONDS = 60
+QUEUE_MAX_ATTEMPTS = 3
+QUEUE_POLL_SECONDS = 2
+
+
+
+def use_corpus_state(corpus_path):
+    """
+    Keep a corpus's results in their own cache, history, hit dictionaries,
+    checkpoint and schedule next to the corpus, so corpus and API runs
+    don't overwrite each other's entries, churn each other's history or
+    resume each other's runs.
+    """
+    global CACHE_PATH, CHECKPOINT_PATH, CHECKPOINT_CURSOR_PATH, SCHEDULE_PATH, HISTORY_PATH, HITS_DICT_PATH
+    corpus_path = os.path.abspath(corpus_path)
+    CACHE_PATH = corpus_path + '.cache.json'
+    CHECKPOINT_PATH = corpus_path + '.checkpoint.json'
+    CHECKPOINT_CURSOR_PATH = CHECKPOINT_PATH + '.cursor'
+    SCHEDULE_PATH = corpus_path + '.schedule.json'
+    HISTORY_PATH = corpus_path + '.history.jsonl'
+    HITS_DICT_PATH = corpus_path + '.hits-{}.dict'
+
+
+def load_cache(path=None):
+    """Load cached search results from disk (CACHE_PATH unless path is given)."""
+    path = path or CACHE_PATH
+    if os.path.exists(path):
+        with open(path, 'rb') as f:
+            return _json_loads(f.read())
+    return {}
+
+
+def save_cache(cache):
+    """
+    Write cached search results to disk. The file is replaced atomically,
+    so an interrupted or forced exit never leaves a truncated cache.
+    """
+    tmp_path = CACHE_PATH + '.tmp'
+    with open(tmp_path, 'w', encoding='utf-8') as f:
+        json.dump(cache, f, indent=2, ensure_ascii=False)
+    os.replace(tmp_path, CACHE_PATH)
+
+
+class HitCodec:
+    """
+    Compress a contact's hit list with a preset dictionary. The codec id
+    ('zlib', or the kind and a hash of the dictionary) is stored with each
+    compressed entry so it is always decoded with the dictionary it was
+    written with.
+    """
+
+    def __init__(self, kind='zlib', dictionary=b''):
+        self.kind = kind
+        self.dictionary = dictionary
+        self.id = f"{kind}-{hashlib.sha256(dictionary).hexdigest()[:12]}" if dictionary else kind
+        if kind == 'zstd':
+            self._zstd_dict = zstandard.ZstdCompressionDict(dictionary)
+
+    def compress(self, hits):
+        data = json.dumps(hits, ensure_ascii=False, separators=(',', ':')).encode('utf-8')
+        if self.kind == 'zstd':
+            blob = zstandard.ZstdCompressor(level=HITS_ZSTD_LEVEL, dict_data=self._zstd_dict).compress(data)
+        else:
+            compressor = zlib.compressobj(9, zlib.DEFLATED, -15, zdict=self.dictionary) \
+                if self.dictionary else zlib.compressobj(9, zlib.DEFLATED, -15)
+            blob = compressor.compress(data) + compressor.flush()
+        return f"{self.id}:{base64.b64encode(blob).decode('ascii')}"
+
+    def decompress(self, data):
+        blob = base64.b64decode(data)
+        if self.kind == 'zstd':
+            data = zstandard.ZstdDecompressor(dict_data=self._zstd_dict).decompress(blob)
+        else:
+            decompressor = zlib.decompressobj(-15, zdict=self.dictionary) \
+                if self.dictionary else zlib.decompressobj(-15)
+            data = decompressor.decompress(blob) + decompressor.flush()
+        return _json_loads(data)
+
+    @classmethod
+    def load(cls, codec_id):
+        if codec_id == 'zlib':
+            return cls()
+        kind = codec_id.split('-', 1)[0]
+        if kind == 'zstd' and not HAS_ZSTANDARD:
+            raise ValueError("Cached hits were compressed with zstandard; install it to read them: "
+                             "pip install zstandard")
+        with open(HITS_DICT_PATH.format(codec_id), 'rb') as f:
+            return cls(kind, f.read())
+
+
+_hit_codecs = {}
+_current_hit_codec = None
+
+
+def hit_codec(codec_id):
+    """The codec for an id, loading its dictionary on first use."""
+    if codec_id not in _hit_codecs:
+        _hit_codecs[codec_id] = HitCodec.load(codec_id)
+    return _hit_codecs[codec_id]
+
+
+def hit_dictionary_ids():
+    """Ids of the trained dictionaries on disk, newest first."""
+    prefix, suffix = os.path.basename(HITS_DICT_PATH).split('{}')
+    directory = os.path.dirname(HITS_DICT_PATH)
+    found = [name for name in os.listdir(directory) if name.startswith(prefix) and name.endswith(suffix)]
+    found.sort(key=lambda name: os.path.getmtime(os.path.join(directory, name)), reverse=True)
+    return [name[len(prefix):len(name) - len(suffix)] for name in found]
+
+
+def current_hit_codec():
+    """The codec new cache entries are compressed with: the newest usable dictionary."""
+    global _current_hit_codec
+    if _current_hit_codec is None:
+        _current_hit_codec = HitCodec()
+        for codec_id in hit_dictionary_ids():
+            if codec_id.startswith('zlib-') or HAS_ZSTANDARD:
+                _current_hit_codec = hit_codec(codec_id)
+                break
+    return _current_hit_codec
+
+
+def reload_hit_codec():
+    """Pick the codec again on next use, in case another process trained a newer dictionary."""
+    global _current_hit_codec
+    _current_hit_codec = None
+
+
+def compress_hits(hits):
+    return current_hit_codec().compress(hits)
+
+
+def entry_hits(entry):
+    """A cache entry's hits, decompressing them if stored compressed."""
+    if 'hits_z' in entry:
+        codec_id, _, data = entry['hits_z'].partition(':')
+        return hit_codec(codec_id).decompress(data)
+    return entry.get('hits', [])
+
+
+def build_zlib_dictionary(samples, size, segment_bytes=64, dmer_bytes=8):
+    """
+    Pick the byte segments of samples that best cover substrings shared
+    across many samples, in the spirit of zstd's COVER trainer. Each
+    8-byte substring scores the number of samples containing it; segments
+    are chosen greedily by the total score of substrings not yet covered.
+    The best segments go last, where zlib reaches them most cheaply.
+    """
+    frequency = {}
+    for sample in samples:
+        for dmer in {sample[i:i + dmer_bytes] for i in range(len(sample) - dmer_bytes + 1)}:
+            frequency[dmer] = frequency.get(dmer, 0) + 1
+
+    def score(segment):
+        return sum(frequency.get(dmer, 0) for dmer in
+                   {segment[i:i + dmer_bytes] for i in range(len(segment) - dmer_bytes + 1)})
+
+    candidates = []
+    for sample in samples:
+        for start in range(0, max(len(sample) - segment_bytes, 0) + 1, segment_bytes // 2):
+            segment = sample[start:start + segment_bytes]
+            candidates.append((-score(segment), segment))
+    heapq.heapify(candidates)
+
+    chosen, total = [], 0
+    while candidates and total < size:
+        _, segment = heapq.heappop(candidates)
+        current = score(segment)
+        if current <= len(segment):
+            continue  # Mostly covered already, or not shared by other samples
+        if candidates and -candidates[0][0] > current:
+            heapq.heappush(candidates, (-current, segment))
+            continue
+        chosen.append(segment)
+        total += len(segment)
+        for i in range(len(segment) - dmer_bytes + 1):
+            frequency.pop(segment[i:i + dmer_bytes], None)
+
+    return b''.join(reversed(chosen))[-size:]
+
+
+def train_hit_dictionary(cache):
+    """
+    Train a dictionary on the cache's hits, recompress every entry with it
+    and save the cache. The new dictionary is written before the cache, and
+    superseded ones are kept: a process that loaded the cache earlier can
+    still save entries compressed with them. Returns the codec, or None if
+    there is nothing shared to train on. Call with the cache lock held (see
+    train_shared_hit_dictionary) when other processes may share the cache.
+    """
+    global _current_hit_codec
+
+    entries = [entry for entry in cache.values() if entry.get('total_hits')]
+    random.Random(0).shuffle(entries)
+    samples, sampled = [], 0
+    for entry in entries:
+        sample = json.dumps(entry_hits(entry), ensure_ascii=False, separators=(',', ':')).encode('utf-8')
+        samples.append(sample)
+        sampled += len(sample)
+        if sampled >= HITS_DICT_SAMPLE_BYTES:
+            break
+    codec = None
+    if HAS_ZSTANDARD:
+        try:
+            dictionary = zstandard.train_dictionary(HITS_ZSTD_DICT_SIZE, samples, k=200, d=8).as_bytes()
+            codec = HitCodec('zstd', dictionary)
+        except zstandard.ZstdError:
+            pass  # Too few samples; the zlib trainer copes with any amount
+    if codec is None:
+        codec = HitCodec('zlib', build_zlib_dictionary(samples, HITS_ZLIB_DICT_SIZE))
+    if not codec.dictionary:
+        return None
+
+    dict_path = HITS_DICT_PATH.format(codec.id)
+    with open(dict_path + '.tmp', 'wb') as f:
+        f.write(codec.dictionary)
+    os.replace(dict_path + '.tmp', dict_path)
+
+    for entry in cache.values():
+        hits = entry_hits(entry)
+        entry.pop('hits', None)
+        entry['hits_z'] = codec.compress(hits)
+    save_cache(cache)
+
+    _hit_codecs[codec.id] = _current_hit_codec = codec
+    return codec
+
+
+def train_shared_hit_dictionary(force=False):
+    """
+    Train a hit dictionary under the cache lock, on a freshly loaded cache,
+    so processes sharing the cache (--queue workers) neither save over each
+    other's results nor train at the same time. Unless force is set, it
+    only trains when no dictionary exists yet and at least
+    HITS_DICT_MIN_ENTRIES contacts have hits; the check is made inside
+    the lock. Returns (codec or None, the cache as saved).
+    """
+    with locked_file(CACHE_PATH + '.lock'):
+        cache = load_cache()
+        if not force and (hit_dictionary_ids() or sum(
+                1 for entry in cache.values() if entry.get('total_hits')) < HITS_DICT_MIN_ENTRIES):
+            return None, cache
+        return train_hit_dictionary(cache), cache
+
+
+def _write_json_atomic(path, data):
+    """Write JSON via a temporary file so readers never see a partial file."""
+    tmp_path = path + '.tmp'
+    with open(tmp_path, 'w', encoding='utf-8') as f:
+        json.dump(data, f, ensure_ascii=False)
+    os.replace(tmp_path, path)
+
+
+def save_checkpoint(contacts, planned):
+    """
+    Persist a run's plan: the sorted contacts and the indexes of those to
+    search. Written once per run; progress goes to the small cursor file.
+    """
+    _write_json_atomic(CHECKPOINT_PATH, {
+        'created': datetime.now().isoformat(),
+        'contacts': contacts,
+        'queue': planned,
+    })
+    save_checkpoint_cursor(0, 0.25, [])
+
+
+def save_checkpoint_cursor(cursor, delay, done_ahead):
+    """
+    Persist the position in the planned queue and the current delay.
+    With parallel searches, done_ahead lists positions past the cursor
+    that already finished, so a resume doesn't repeat them.
+    """
+    _write_json_atomic(CHECKPOINT_CURSOR_PATH, {'cursor': cursor, 'delay': delay, 'done_ahead': done_ahead})
+
+
+def load_checkpoint():
+    """Load the last run's checkpoint, or None if there isn't one."""
+    if not os.path.exists(CHECKPOINT_PATH):
+        return None
+
+    with open(CHECKPOINT_PATH, 'rb') as f:
+        checkpoint = _json_loads(f.read())
+
+    if os.path.exists(CHECKPOINT_CURSOR_PATH):
+        with open(CHECKPOINT_CURSOR_PATH, 'rb') as f:
+            checkpoint.update(_json_loads(f.read()))
+    else:
+        checkpoint.update({'cursor': 0, 'delay': 0.25, 'done_ahead': []})
+
+    return checkpoint
+
+
+def clear_checkpoint():
+    """Remove the checkpoint once a run has finished its plan."""
+    for path in (CHECKPOINT_PATH, CHECKPOINT_CURSOR_PATH):
+        if os.path.exists(path):
+            os.remove(path)
+
+
+def load_schedule():
+    """Load the persisted refresh schedule, or an empty one."""
+    if os.path.exists(SCHEDULE_PATH):
+        with open(SCHEDULE_PATH, 'rb') as f:
+            return _json_loads(f.read())
+    return {'next_refresh': {}, 'used': {}}
+
+
+def save_schedule(schedule):
+    _write_json_atomic(SCHEDULE_PATH, schedule)
+
+
+def refresh_priority(cached_entry):
+    """
+    Sort key for competing refreshes; lower goes first. Never-searched
+    contacts come first, then contacts with mentions (most first), then
+    the rest.
+    """
+    if cached_entry is None:
+        return (0, 0)
+    if cached_entry.get('total_hits', 0) > 0:
+        return (1, -cached_entry['total_hits'])
+    return (2, 0)
+
+
+def plan_refresh_schedule(contacts, cache, quota, today=None, skip=(), reserved=0, reserved_now=0):
+    """
+    Assign every contact a refresh day so no day exceeds `quota` searches,
+    less `reserved` searches a day held back for the watchlist lane (today
+    holds back its share of the hours left, plus `reserved_now` for the
+    watched contacts already due). reserved must be below quota.
+
+    A contact can't be scheduled before its cache entry expires (after
+    CACHE_TTL_HOURS). It keeps its previously scheduled day when that day
+    is still valid and has room, so the plan is stable from one run to
+    the next. Otherwise it goes to the first day from its due date that
+    has room, and higher-priority contacts are placed first.
+
+    Returns (planned, schedule). planned lists the indexes into contacts
+    to search today, in priority order. schedule is the updated schedule
+    to persist. Contacts whose indexes are in skip are left unscheduled.
+    """
+    today = today or date.today()
+    schedule = load_schedule()
+    previous = schedule.get('next_refresh', {})
+    used = {day: count for day, count in schedule.get('used', {}).items()
+            if date.fromisoformat(day) >= today - timedelta(days=SCHEDULE_HISTORY_DAYS)}
+
+    entries = []
+    seen = set()
+    for i, contact in enumerate(contacts):
+        name = contact['full_name']
+        if name in seen or i in skip:
+            continue
+        seen.add(name)
+
+        cached_entry = cache.get(name)
+        due = today
+        if cached_entry and 'last_searched' in cached_entry:
+            expires = datetime.fromisoformat(cached_entry['last_searched']) + timedelta(hours=CACHE_TTL_HOURS)
+            due = max(expires.date(), today)
+        entries.append((refresh_priority(cached_entry), due, i, name))
+
+    capacity = quota - reserved
+    reserved_today = reserved_share_today(reserved) + reserved_now
+    remaining = {today: max(quota - reserved_today - used.get(today.isoformat(), 0), 0)}
+    next_open = {}  # full day -> a later day to try, path-compressed
+
+    def first_open_day(day):
+        path = []
+        while remaining.setdefault(day, capacity) <= 0:
+            path.append(day)
+            day = next_open.get(day, day + timedelta(days=1))
+        for full_day in path:
+            next_open[full_day] = day
+        return day
+
+    assigned = {}
+
+    # Keep still-valid previous assignments, highest priority first
+    for priority, due, i, name in sorted(entries):
+        if name in previous:
+            day = date.fromisoformat(previous[name])
+            if day >= due and remaining.setdefault(day, capacity) > 0:
+                assigned[name] = day
+                remaining[day] -= 1
+
+    # Place everything else at the first day with room
+    for priority, due, i, name in sorted(entries, key=lambda e: (e[1], e[0])):
+        if name not in assigned:
+            day = first_open_day(due)
+            assigned[name] = day
+            remaining[day] -= 1
+
+    planned = [i for priority, due, i, name in sorted(entries) if assigned[name] == today]
+
+    schedule = {
+        'quota': quota,
+        'reserved': reserved,
+        'reserved_now': reserved_now,
+        'updated': datetime.now().isoformat(),
+        'next_refresh': {name: day.isoformat() for name, day in assigned.items()},
+        'used': used,
+    }
+    return planned, schedule
+
+
+def reserved_share_today(reserved):
+    """The part of a daily reservation falling in what's left of today."""
+    now = datetime.now()
+    midnight = datetime.combine(now.date() + timedelta(days=1), datetime.min.time())
+    return math.ceil(reserved * (midnight - now).total_seconds() / 86400)
+
+
+def watch_lane_searches_per_day(watched, watchlist_ttl_hours):
+    """Searches a day the watchlist lane makes, refreshing every watched contact each TTL."""
+    return math.ceil(len(watched) * 24 / watchlist_ttl_hours)
+
+
+def watched_due_now(contacts, cache, watched, watchlist_ttl_hours):
+    """Watched contacts the lane refreshes as soon as a run starts: never searched, or not within the TTL."""
+    cutoff = datetime.now() - timedelta(hours=watchlist_ttl_hours)
+    due = 0
+    for i in watched:
+        cached_entry = cache.get(contacts[i]['full_name'])
+        if not cached_entry or 'last_searched' not in cached_entry \
+                or datetime.fromisoformat(cached_entry['last_searched']) <= cutoff:
+            due += 1
+    return due
+
+
+def print_quota_projection(schedule, days=7):
+    """Print projected searches per day (including the watchlist reservation) against the daily quota."""
+    per_day = {}
+    for day in schedule['next_refresh'].values():
+        per_day[day] = per_day.get(day, 0) + 1
+
+    today = date.today()
+    quota = schedule['quota']
+    print("\nProjected quota use:")
+    for offset in range(days):
+        day = (today + timedelta(days=offset)).isoformat()
+        reserved = schedule.get('reserved', 0)
+        if offset == 0:
+            scheduled = (per_day.get(day, 0) + schedule['used'].get(day, 0) + reserved_share_today(reserved)
+                         + schedule.get('reserved_now', 0))
+        else:
+            scheduled = per_day.get(day, 0) + reserved
+        print(f"  {day}  {scheduled:6,} / {quota:,}  {'#' * round(20 * scheduled / quota)}")
+
+    later = sum(count for day, count in per_day.items() if day >= (today + timedelta(days=days)).isoformat())
+    if later:
+        print(f"  later       {later:6,}")
+    print()
+
+
+def record_quota_use(searches):
+    """Add this run's searches to today's quota usage."""
+    schedule = load_schedule()
+    today = date.today().isoformat()
+    schedule.setdefault('used', {})[today] = schedule['used'].get(today, 0) + searches
+    save_schedule(schedule)
+
+
+def hit_doc_id(hit):
+    """Stable document identifier for a hit."""
+    return hit.get('file_path') or hit.get('doj_url') or ''
+
+
+class HistoryStore:
+    """
+    Append-only mention history, one JSON line per change:
+        {"c": contact, "t": timestamp, "n": total_hits, "+": [doc ids], "-": [doc ids]}
+    "+"/"-" are the documents added to/removed from the contact's hits
+    since the previous record. Refreshes that change nothing write nothing,
+    so the file grows with changes rather than with refreshes. A contact's
+    implicit starting state is 0 hits and no documents.
+
+    Each contact's current state is replayed from the file itself, and
+    records appended since the last read (including by other processes
+    sharing the file) are applied before every comparison.
+    """
+
+    def __init__(self, path=None):
+        self.path = path or HISTORY_PATH
+        self.states = {}  # contact -> (total_hits, doc ids) as of its last record
+        self.offset = 0
+
+    def _catch_up(self):
+        """Apply the records appended since the last read."""
+        if not os.path.exists(self.path):
+            return
+        with open(self.path, 'rb') as f:
+            f.seek(self.offset)
+            for line in f:
+                if not line.endswith(b'\n'):
+                    break  # Still being written
+                self.offset += len(line)
+                record = json.loads(line)
+                _, docs = self.states.get(record['c'], (0, frozenset()))
+                docs = (docs - set(record.get('-', ()))) | set(record.get('+', ()))
+                self.states[record['c']] = (record['n'], frozenset(docs))
+
+    def record(self, name, total_hits, hits):
+        """Append a record if total_hits or the document set changed since the contact's last record."""
+        self._catch_up()
+        previous_total, previous_docs = self.states.get(name, (0, frozenset()))
+        docs = {hit_doc_id(h) for h in hits}
+
+        if total_hits == previous_total and docs == previous_docs:
+            return False
+
+        record = {'c': name, 't': datetime.now().isoformat(timespec='seconds'), 'n': total_hits}
+        if docs - previous_docs:
+            record['+'] = sorted(docs - previous_docs)
+        if previous_docs - docs:
+            record['-'] = sorted(previous_docs - docs)
+
+        with open(self.path, 'a', encoding='utf-8') as f:
+            f.write(json.dumps(record, ensure_ascii=False) + '\n')
+        self._catch_up()
+        return True
+
+    def records(self, name=None):
+        """Iterate over stored records, optionally for one contact."""
+        if not os.path.exists(self.path):
+            return
+        with open(self.path, 'r', encoding='utf-8') as f:
+            for line in f:
+                record = json.loads(line)
+                if name is None or record['c'] == name:
+                    yield record
+
+    def series(self):
+        """Map each contact to its [(timestamp, total_hits), ...] series."""
+        series = {}
+        for record in self.records():
+            series.setdefault(record['c'], []).append((record['t'], record['n']))
+        return series
+
+
+def print_history(history, name):
+    """Print a contact's mention timeline, including when they first appeared."""
+    records = list(history.records(name))
+    if not records:
+        print(f"No mention history for {name}.")
+        return
+
+    first = next((r for r in records if r['n'] > 0), None)
+    if first:
+        print(f"{name} first appeared on {first['t']} with {first['n']:,} mentions.")
+    else:
+        print(f"{name} has history records but no mentions.")
+
+    print("\nTimeline:")
+    for r in records:
+        change = []
+        if r.get('+'):
+            change.append(f"+{len(r['+'])} documents")
+        if r.get('-'):
+            change.append(f"-{len(r['-'])} documents")
+        print(f"  {r['t']}  {r['n']:6,} mentions  {', '.join(change)}")
+
+
+def normalize_name(name):
+    """Case- and whitespace-insensitive form of a name for matching."""
+    return ' '.join(name.lower().split())
+
+
+def normalize_profile_url(url):
+    """Reduce a LinkedIn profile URL to host/path for matching."""
+    url = url.strip().lower().split('?')[0].split('#')[0].rstrip('/')
+    url = re.sub(r'^[a-z]+://', '', url)
+    return re.sub(r'^www\.', '', url)
+
+
+def load_watchlist(path):
+    """
+    Read a watchlist: one contact name or LinkedIn profile URL per line.
+    Blank lines and lines starting with # are ignored.
+    Returns (names, urls), both normalized.
+    """
+    names, urls = set(), set()
+    with open(path, 'r', encoding='utf-8-sig') as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            if 'linkedin.com/' in line.lower():
+                urls.add(normalize_profile_url(line))
+            else:
+                names.add(normalize_name(line))
+    return names, urls
+
+
+def watched_contacts(contacts, watchlist):
+    """Return the set of indexes of contacts that are on the watchlist."""
+    names, urls = watchlist
+    return {
+        i for i, contact in enumerate(contacts)
+        if normalize_name(contact['full_name']) in names
+        or (contact.get('url') and normalize_profile_url(contact['url']) in urls)
+    }
+
+
+def get_api_key():
+    """Load API key from disk, or prompt the user for one."""
+    if os.path.exists(API_KEY_PATH):
+        with open(API_KEY_PATH, 'r') as f:
+            key = f.read().strip()
+            if key:
+                return key
+
+    print("An API key is required to search the Epstein files.")
+    print("To obtain one, visit: https://epstein.dugganusa.com/register.html")
+    print()
+    api_key = input("Enter your API key: ").strip()
+
+    if not api_key:
+        print("Error: No API key provided.", file=sys.stderr)
+        sys.exit(1)
+
+    with open(API_KEY_PATH, 'w') as f:
+        f.write(api_key)
+
+    print(f"API key saved to {API_KEY_PATH}\n")
+    return api_key
+
+
+def _contact_from_row(row):
+    """Build a contact from a Connections.csv row, or None if it has no name."""
+    first_name = (row.get('First Name') or '').strip()
+    last_name = (row.get('Last Name') or '').strip()
+
+    # Remove credentials/certifications (everything after the first comma)
+    if ',' in last_name:
+        last_name = last_name.split(',')[0].strip()
+
+    if not (first_name and last_name):
+        return None
+
+    return {
+        'first_name': first_name,
+        'last_name': last_name,
+        'full_name': f"{first_name} {last_name}",
+        'company': row.get('Company') or '',
+        'position': row.get('Position') or '',
+        'url': row.get('URL') or '',
+    }
+
+
+def _parse_contacts_range(csv_path, start, end, fieldnames):
+    """Parse the rows in bytes [start, end) of a connections CSV (worker process)."""
+    with open(csv_path, 'rb') as f:
+        f.seek(start)
+        text = f.read(end - start).decode('utf-8')
+    reader = csv.DictReader(io.StringIO(text, newline=''), fieldnames=fieldnames)
+    return [contact for contact in map(_contact_from_row, reader) if contact]
+
+
+def _count_quotes(data, start, end, block=1 << 20):
+    return sum(data[i:min(i + block, end)].count(b'"') for i in range(start, end, block))
+
+
+def csv_row_boundaries(data, start, end, parts):
+    """
+    Split data[start:end] into up to parts byte ranges that each begin at a
+    row boundary. A newline ends a row only when the quotes before it are
+    balanced, so each nominal split point is moved forward to the first
+    newline with an even quote count since start. Quote counts are carried
+    from split point to split point, so the file is scanned once.
+    """
+    boundaries = [start]
+    position, quotes = start, 0
+    for part in range(1, parts):
+        target = start + (end - start) * part // parts
+        if target <= position:
+            continue
+        quotes += _count_quotes(data, position, target)
+        position = target
+        while position < end:
+            newline = data.find(b'\n', position, end)
+            if newline < 0:
+                position = end
+                break
+            quotes += _count_quotes(data, position, newline)
+            position = newline + 1
+            if quotes % 2 == 0:
+                break
+        if position >= end:
+            break
+        boundaries.append(position)
+    boundaries.append(end)
+    return list(zip(boundaries, boundaries[1:]))
+
+
+def csv_dict_rows(f, columns):
+    """
+    Stream the rows of a LinkedIn CSV as dicts, starting at the first line
+    that names all of columns. LinkedIn includes a "Notes" section at the
+    top of some exports that must be skipped.
+    """
+    for line in f:
+        if all(column in line for column in columns):
+            return csv.DictReader(itertools.chain([line], f))
+    return iter(())
+
+
+def parse_linkedin_contacts(csv_path, workers=0):
+    """
+    Parse LinkedIn connections CSV export.
+    LinkedIn exports have columns: First Name, Last Name, Email Address, Company, Position, Connected On
+
+    Rows are streamed; files of PARALLEL_PARSE_MIN_BYTES or more are split
+    into quote-aware byte ranges parsed by worker processes and merged in
+    file order. workers is the number of processes; 0 picks one per CPU
+    for large files.
+    """
+    if workers == 0:
+        workers = (os.cpu_count() or 1) if os.path.getsize(csv_path) >= PARALLEL_PARSE_MIN_BYTES else 1
+
+    if workers > 1:
+        contacts = _parse_linkedin_contacts_parallel(csv_path, workers)
+        if contacts is not None:
+            return contacts
+
+    with open(csv_path, 'r', encoding='utf-8-sig', newline='') as f:
+        return [contact for contact in map(_contact_from_row, csv_dict_rows(f, ('First Name', 'Last Name')))
+                if contact]
+
+
+def _parse_linkedin_contacts_parallel(csv_path, workers):
+    """
+    Parallel path of parse_linkedin_contacts. Returns None if the header
+    row can't be located, so the caller falls back to the sequential parser.
+    """
+    with open(csv_path, 'rb') as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+    with data:
+        position = 3 if data[:3] == b'\xef\xbb\xbf' else 0
+        fieldnames = None
+        while position < len(data):
+            line_end = data.find(b'\n', position)
+            line_end = len(data) if line_end < 0 else line_end + 1
+            line = data[position:line_end].decode('utf-8', errors='replace')
+            position = line_end
+            if 'First Name' in line and 'Last Name' in line:
+                fieldnames = next(csv.reader([line]))
+                break
+
+        if fieldnames is None:
+            return None
+
+        ranges = csv_row_boundaries(data, position, len(data), workers * PARSE_CHUNKS_PER_WORKER)
+
+    contacts = []
+    with concurrent.futures.ProcessPoolExecutor(max_workers=workers) as pool:
+        # map() yields chunks in submission order, so rows stay in file order.
+        for chunk in pool.map(_parse_contacts_range, itertools.repeat(csv_path),
+                              *zip(*ranges), itertools.repeat(fieldnames)):
+            contacts.extend(chunk)
+    return contacts
+
+
+@contextlib.contextmanager
+def open_archive_csv(archive_path, filename):
+    """
+    Open one CSV of a LinkedIn data archive (the downloaded ZIP or its
+    extracted directory) as a streamed text file, or yield None if the
+    archive doesn't contain it. Files are matched by name in any folder.
+    """
+    filename = filename.lower()
+    if os.path.isdir(archive_path):
+        for root, _, files in os.walk(archive_path):
+            for name in files:
+                if name.lower() == filename:
+                    with open(os.path.join(root, name), 'r', encoding='utf-8-sig', newline='') as f:
+                        yield f
+                    return
+        yield None
+        return
+
+    with zipfile.ZipFile(archive_path) as archive:
+        for info in archive.infolist():
+            if os.path.basename(info.filename).lower() == filename:
+                with archive.open(info) as raw:
+                    yield io.TextIOWrapper(raw, encoding='utf-8-sig', newline='')
+                return
+    yield None
+
+
+def _archive_contact(full_name='', first_name='', last_name='', company='', position='', url=''):
+    """Normalize a person named in an archive file into a contact, or None."""
+    if full_name:
+        # Remove credentials/certifications (everything after the first comma)
+        first_name, _, last_name = full_name.split(',')[0].strip().partition(' ')
+    first_name = first_name.strip()
+    last_name = last_name.split(',')[0].strip()
+    if not (first_name and last_name) or f"{first_name} {last_name}" in ARCHIVE_PLACEHOLDER_NAMES:
+        return None
+    return {
+        'first_name': first_name,
+        'last_name': last_name,
+        'full_name': f"{first_name} {last_name}",
+        'company': company or '',
+        'position': position or '',
+        'url': url or '',
+    }
+
+
+def _archive_people(row, field):
+    """The _archive_contact arguments for each person a field names in one row."""
+    values = {key: row.get(column) or '' for key, column in field.items()}
+    if 'full_names' not in values:
+        return [values]
+    names = [name for name in values.pop('full_names').split(',') if name.strip()]
+    urls = [url.strip() for url in values.pop('urls', '').split(',') if url.strip()]
+    if len(urls) != len(names):
+        # Credentials after a name ("Jane Doe, MBA") split into extra entries
+        urls = [''] * len(names)
+    return [dict(values, full_name=name, url=url) for name, url in zip(names, urls)]
+
+
+def parse_archive_connections(archive_path, workers=0):
+    """Parse Connections.csv out of a LinkedIn data archive."""
+    if os.path.isdir(archive_path):
+        with open_archive_csv(archive_path, 'Connections.csv') as f:
+            if f is not None:
+                return parse_linkedin_contacts(f.name, workers)
+        return []
+
+    with open_archive_csv(archive_path, 'Connections.csv') as f:
+        if f is None:
+            return []
+        return [contact for contact in map(_contact_from_row, csv_dict_rows(f, ('First Name', 'Last Name')))
+                if contact]
+
+
+def parse_archive_contacts(archive_path, connections):
+    """
+    Collect people from the rest of a LinkedIn data archive: message
+    senders and recipients, invitations, imported address-book contacts and
+    endorsements. Files are streamed row by row. Each new person is tagged
+    with the archive file it came from; people already among connections
+    (by name or profile URL), seen in an earlier file, or the archive's
+    owner (from Profile.csv) are skipped.
+    Returns (contacts, {source: count}).
+    """
+    seen_names = {normalize_name(contact['full_name']) for contact in connections}
+    seen_urls = {normalize_profile_url(contact['url']) for contact in connections if contact.get('url')}
+
+    with open_archive_csv(archive_path, 'Profile.csv') as f:
+        if f is not None:
+            for row in csv_dict_rows(f, ('First Name', 'Last Name')):
+                owner = _archive_contact('', row.get('First Name') or '', row.get('Last Name') or '')
+                if owner:
+                    seen_names.add(normalize_name(owner['full_name']))
+                break
+
+    contacts = []
+    counts = {}
+    for source, filename, columns, fields in ARCHIVE_SOURCES:
+        with open_archive_csv(archive_path, filename) as f:
+            if f is None:
+                continue
+            for row in csv_dict_rows(f, columns):
+                for field in fields:
+                    for values in _archive_people(row, field):
+                        contact = _archive_contact(**values)
+                        if contact is None:
+                            continue
+                        name_key = normalize_name(contact['full_name'])
+                        url_key = normalize_profile_url(contact['url']) if contact['url'] else None
+                        if name_key in seen_names or (url_key and url_key in seen_urls):
+                            continue
+                        seen_names.add(name_key)
+                        if url_key:
+                            seen_urls.add(url_key)
+                        contact['source'] = source
+                        contacts.append(contact)
+                        counts[source] = counts.get(source, 0) + 1
+
+    return contacts, counts
+
+
+def slim_hit(hit):
+    """Keep only the hit fields the report uses, truncating long content."""
+    slim = {field: hit[field] for field in HIT_FIELDS if hit.get(field)}
+    if 'content' in slim:
+        if slim.get('content_preview'):
+            del slim['content']
+        else:
+            slim['content'] = slim['content'][:HIT_CONTENT_CHARS]
+    return slim
+
+
+def parse_search_response(response):
+    """
+    Decode a search response into (success, total_hits, hits).
+    Large responses are parsed incrementally with ijson when available, so
+    unused fields are never materialized; otherwise the body is decoded in
+    one go (with orjson when available).
+    """
+    length = response.headers.get('Content-Length')
+    if HAS_IJSON and (length is None or int(length) >= STREAMING_PARSE_MIN_BYTES):
+        response.raw.decode_content = True
+        success, total_hits, hits, hit = False, 0, [], None
+        hit_prefix = 'data.hits.item'
+
+        for prefix, event, value in ijson.parse(response.raw):
+            if prefix == 'success':
+                success = bool(value)
+            elif prefix == 'data.totalHits':
+                total_hits = int(value)
+            elif prefix == hit_prefix:
+                if event == 'start_map':
+                    hit = {}
+                elif event == 'end_map':
+                    hits.append(slim_hit(hit))
+                    hit = None
+            elif hit is not None and event == 'string' and prefix.startswith(hit_prefix + '.'):
+                field = prefix[len(hit_prefix) + 1:]
+                if field in HIT_FIELDS:
+                    hit[field] = value
+
+        return success, total_hits, hits
+
+    data = _json_loads(response.content)
+    payload = data.get('data', {})
+    return (
+        bool(data.get('success')),
+        payload.get('totalHits', 0),
+        [slim_hit(hit) for hit in payload.get('hits', [])],
+    )
+
+
+def _backoff(delay, stop_event):
+    """Sleep before a retry. Returns False if shutdown was requested meanwhile."""
+    if stop_event is None:
+        time.sleep(delay)
+        return True
+    return not stop_event.wait(delay)
+
+
+class Tracer:
+    """
+    Span recorder that writes Chrome trace-event JSON (open the file in
+    Perfetto or chrome://tracing). Pipeline phases are always recorded;
+    per-search spans are kept for a sample_rate fraction of searches so
+    large runs produce a manageable trace. A tracer without a path is a
+    no-op.
+    """
+
+    def __init__(self, path=None, sample_rate=1.0):
+        self.path = path
+        self.enabled = path is not None
+        self.sample_rate = sample_rate
+        self.events = []
+        self.thread_ids = {}
+        self.lock = threading.Lock()
+        self.rng = random.Random()
+        self.origin = time.perf_counter()
+
+    def sampled(self):
+        """Decide whether to trace one search (and its cache flush)."""
+        return self.enabled and self.rng.random() < self.sample_rate
+
+    @contextlib.contextmanager
+    def span(self, name, enabled=True, **args):
+        """
+        Record the enclosed block as a span. Yields the span's args dict so
+        results (status codes, counts) can be attached before it closes.
+        Spans nest by time on the same thread, so retries inside a search
+        show up as its children.
+        """
+        if not (self.enabled and enabled):
+            yield {}
+            return
+
+        start = time.perf_counter()
+        try:
+            yield args
+        finally:
+            end = time.perf_counter()
+            thread = threading.current_thread()
+            with self.lock:
+                tid = self.thread_ids.setdefault(thread.ident, (len(self.thread_ids) + 1, thread.name))[0]
+                self.events.append({
+                    'name': name,
+                    'ph': 'X',
+                    'ts': round((start - self.origin) * 1e6, 1),
+                    'dur': round((end - start) * 1e6, 1),
+                    'pid': os.getpid(),
+                    'tid': tid,
+                    'args': args,
+                })
+
+    def save(self):
+        if not self.enabled:
+            return
+
+        with self.lock:
+            metadata = [
+                {'name': 'thread_name', 'ph': 'M', 'pid': os.getpid(), 'tid': tid, 'args': {'name': thread_name}}
+                for tid, thread_name in self.thread_ids.values()
+            ]
+            with open(self.path, 'w', encoding='utf-8') as f:
+                json.dump({'traceEvents': metadata + self.events, 'displayTimeUnit': 'ms'}, f)
+
+
+# Shared no-op tracer for callers that don't trace
+NULL_TRACER = Tracer()
+
+
+@contextlib.contextmanager
+def locked_file(path):
+    """Hold an exclusive lock on path (created if missing) across processes; yields its fd."""
+    fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o600)
+    try:
+        if fcntl:
+            fcntl.flock(fd, fcntl.LOCK_EX)
+        else:
+            msvcrt.locking(fd, msvcrt.LK_LOCK, 1)
+        yield fd
+    finally:
+        if not fcntl:
+            os.lseek(fd, 0, os.SEEK_SET)
+            msvcrt.locking(fd, msvcrt.LK_UNLCK, 1)
+        os.close(fd)  # Closing releases the flock
+
+
+class SharedRateLimiter:
+    """
+    Host-wide rate limiter shared by every process using the same API key.
+    The next free request slot is kept in a small state file in the temp
+    directory, guarded by an exclusive file lock. Each request claims the
+    next slot, and a 429 pushes the slot forward for all processes.
+    """
+
+    def __init__(self, api_key, requests_per_second):
+        key_id = hashlib.sha256(api_key.encode('utf-8')).hexdigest()[:16]
+        self.path = os.path.join(tempfile.gettempdir(), f"epsteout-ratelimit-{key_id}")
+        self.interval = 1.0 / requests_per_second
+        self.thread_lock = threading.Lock()
+
+    @contextlib.contextmanager
+    def _locked_state(self):
+        """Yield [next_slot]; the value written back on exit is shared."""
+        with self.thread_lock, locked_file(self.path) as fd:
+            raw = os.read(fd, 64)
+            try:
+                state = [float(raw)]
+            except ValueError:
+                state = [0.0]
+
+            yield state
+
+            os.lseek(fd, 0, os.SEEK_SET)
+            os.ftruncate(fd, 0)
+            os.write(fd, repr(state[0]).encode('ascii'))
+
+    def acquire(self, stop_event=None):
+        """
+        Wait for this process's next request slot. Returns False if
+        shutdown was requested while waiting.
+        """
+        with self._locked_state() as state:
+            slot = max(time.time(), state[0])
+            state[0] = slot + self.interval
+
+        wait = slot - time.time()
+        if wait > 0:
+            return _backoff(wait, stop_event)
+        return True
+
+    def penalize(self, seconds):
+        """Hold every process's requests for `seconds` after a 429."""
+        with self._locked_state() as state:
+            state[0] = max(state[0], time.time() + seconds)
+
+
+def _rate_limit_headers(response):
+    """Collect rate-limit related response headers for logging."""
+    return {
+        key: value for key, value in response.headers.items()
+        if key.lower().startswith(('x-ratelimit', 'ratelimit')) or key.lower() == 'retry-after'
+    }
+
+
+def _response_bytes(response):
+    """Bytes read off the wire for a response, or None if unknown."""
+    try:
+        return response.raw.tell()
+    except (AttributeError, OSError):
+        length = response.headers.get('Content-Length')
+        return int(length) if length else None
+
+
+def search_epstein_files(name, delay, api_key, validators=None, api_url=API_BASE_URL, stop_event=None,
+                         request_log=None, tracer=NULL_TRACER, limiter=None):
+    """
+    Search the Epstein files API for a name.
+    Returns (result_dict, delay) where delay may be increased on 429 responses.
+
+    validators is the cached entry's {'etag', 'last_modified'}; when given,
+    the request is conditional and an unchanged result comes back as
+    {'not_modified': True} without a body.
+
+    If stop_event is set while waiting to retry, the search is abandoned
+    and {'cancelled': True} is returned.
+
+    request_log, if given, receives one record per request attempt, and
+    each attempt is recorded as an 'attempt' span on tracer.
+
+    limiter, a SharedRateLimiter, is consulted before every attempt and
+    told about 429 back-offs.
+    """
+    # Wrap name in quotes for exact phrase matching
+    quoted_name = f'"{name}"'
+    encoded_name = urllib.parse.quote(quoted_name)
+    url = f"{api_url}?q={encoded_name}&indexes=epstein_files"
+    headers = {"Authorization": f"Bearer {api_key}"}
+
+    if validators:
+        if validators.get('etag'):
+            headers['If-None-Match'] = validators['etag']
+        if validators.get('last_modified'):
+            headers['If-Modified-Since'] = validators['last_modified']
+
+    attempt = 0
+
+    while True:
+        rate_limited = False
+        if limiter is not None and not limiter.acquire(stop_event):
+            return {'cancelled': True}, delay
+
+        attempt += 1
+        started = time.monotonic()
+        record = {'event': 'request', 'contact': name, 'attempt': attempt}
+
+        with tracer.span('attempt', attempt=attempt) as span_args:
+            def log(outcome, **fields):
+                span_args['outcome'] = outcome
+                if request_log is not None:
+                    record.update(fields, outcome=outcome, latency_ms=round((time.monotonic() - started) * 1000, 1))
+                    request_log.write(record)
+
+            try:
+                response = requests.get(url, headers=headers, timeout=30, stream=True)
+                record.update(status=response.status_code, rate_limit=_rate_limit_headers(response))
+                span_args['status'] = response.status_code
+
+                if response.status_code == 429:
+                    response.close()
+                    retry_after = response.headers.get('Retry-After')
+
+                    if retry_after:
+                        delay = int(retry_after)
+                    else:
+                        delay *= 2
+
+                    log('rate_limited', backoff_s=delay)
+                    print(f"    [{name}: 429 rate limited, retrying in {delay}s]", flush=True)
+                    rate_limited = True
+                    if limiter is not None:
+                        limiter.penalize(delay)
+
+                elif response.status_code == 304:
+                    response.close()
+                    log('not_modified', bytes=_response_bytes(response))
+                    return {'not_modified': True}, delay
+
+                else:
+                    with response:
+                        response.raise_for_status()
+                        success, total_hits, hits = parse_search_response(response)
+
+                    log('ok' if success else 'unsuccessful', bytes=_response_bytes(response), total_hits=total_hits)
+
+                    if success:
+                        return {
+                            'total_hits': total_hits,
+                            'hits': hits,
+                            'etag': response.headers.get('ETag'),
+                            'last_modified': response.headers.get('Last-Modified'),
+                        }, delay
+
+                    return {'total_hits': 0, 'hits': []}, delay
+            except requests.exceptions.ConnectTimeout:
+                delay *= 2
+                log('connect_timeout', backoff_s=delay)
+                print(f"    [{name}: connect timeout, retrying in {delay}s]", flush=True)
+            except (requests.exceptions.RequestException,) + _JSON_ERRORS as e:
+                log('error', error=str(e))
+                print(f"Warning: API request failed for '{name}': {e}", file=sys.stderr)
+                return {'total_hits': 0, 'hits': [], 'error': str(e)}, delay
+
+        # Rate limited or timed out: back off, then retry. After a 429 the
+        # shared limiter already holds back the next attempt.
+        if rate_limited and limiter is not None:
+            continue
+        if not _backoff(delay, stop_event):
+            return {'cancelled': True}, delay
+
+
+class JsonLogWriter:
+    """
+    Structured log sink: one JSON record per line, appended to a file by a
+    background thread so the search loop never waits on disk I/O.
+    """
+
+    def __init__(self, path):
+        self.file = open(path, 'a', encoding='utf-8', buffering=1 << 16)
+        self.records = queue.Queue()
+        self.thread = threading.Thread(target=self._drain, daemon=True)
+        self.thread.start()
+
+    def write(self, record):
+        """Queue a record; timestamped here, serialized on the writer thread."""
+        record['ts'] = datetime.now().isoformat()
+        self.records.put(record)
+
+    def close(self):
+        self.records.put(None)
+        self.thread.join(timeout=5)
+
+    def _drain(self):
+        while True:
+            record = self.records.get()
+            if record is None:
+                break
+            self.file.write(json.dumps(record, ensure_ascii=False) + '\n')
+            if self.records.empty():
+                self.file.flush()
+        self.file.close()
+
+
+def build_corpus(source_dir, corpus_path):
+    """
+    Pack every .txt file under source_dir into a single corpus file that
+    CorpusStore can memory-map. Documents are streamed to disk one at a
+    time, each followed by CORPUS_SEPARATOR. Their ids mirror the DOJ
+    layout, so "dataset1/EFTA00001.txt" becomes "/dataset1/EFTA00001.pdf".
+    Returns the number of documents written.
+    """
+    paths = []
+    for root, dirs, files in os.walk(source_dir):
+        dirs.sort()
+        paths.extend(os.path.join(root, name) for name in sorted(files) if name.lower().endswith('.txt'))
+
+    offsets = array.array('Q')
+    doc_ids = []
+
+    with open(corpus_path, 'wb') as out:
+        out.write(b'\0' * CORPUS_HEADER.size)
+        text_start = out.tell()
+
+        for path in paths:
+            offsets.append(out.tell() - text_start)
+            with open(path, 'r', encoding='utf-8', errors='replace') as f:
+                out.write(f.read().encode('utf-8'))
+            out.write(CORPUS_SEPARATOR)
+            rel_path = os.path.relpath(path, source_dir).replace(os.sep, '/')
+            doc_ids.append('/' + os.path.splitext(rel_path)[0] + '.pdf')
+        offsets.append(out.tell() - text_start)
+
+        # Align the offset table so it can be viewed in place as uint64s
+        out.write(b'\0' * (-out.tell() % 8))
+        offsets_start = out.tell()
+        out.write(offsets.tobytes())
+
+        ids_start = out.tell()
+        out.write(json.dumps(doc_ids, ensure_ascii=False).encode('utf-8'))
+
+        out.seek(0)
+        out.write(CORPUS_HEADER.pack(CORPUS_MAGIC, CORPUS_VERSION, len(doc_ids), text_start, offsets_start, ids_start))
+
+    return len(doc_ids)
+
+
+class CorpusStore:
+    """
+    Read-only, memory-mapped view of a corpus built by build_corpus.
+    Document text is never loaded as a whole: searches run directly over
+    the mapped bytes and only the snippet windows around matches are
+    sliced out and decoded, so resident memory stays small on multi-GB
+    corpora.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        self.file = open(path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, version, self.doc_count, self.text_start, offsets_start, ids_start = \
+            CORPUS_HEADER.unpack_from(self.map, 0)
+        if magic != CORPUS_MAGIC or version != CORPUS_VERSION:
+            raise ValueError(f"{path} is not a version {CORPUS_VERSION} EpsteOut corpus")
+
+        # Zero-copy view of the document start offsets, relative to text_start
+        self.offsets = memoryview(self.map)[offsets_start:offsets_start + 8 * (self.doc_count + 1)].cast('Q')
+        self.text_end = self.text_start + self.offsets[self.doc_count]
+        self.doc_ids = json.loads(self.map[ids_start:].decode('utf-8'))
+
+    def close(self):
+        self.offsets.release()
+        self.map.close()
+        self.file.close()
+
+    def document_at(self, position):
+        """Index of the document containing a text position (relative to text_start)."""
+        return bisect.bisect_right(self.offsets, position, 0, self.doc_count) - 1
+
+    def document_bounds(self, doc):
+        """(start, end) text positions of a document, excluding its separator."""
+        return self.offsets[doc], self.offsets[doc + 1] - len(CORPUS_SEPARATOR)
+
+    def snippet(self, doc, start, end, context=CORPUS_SNIPPET_CHARS):
+        """Decode a window of text around [start, end), clipped to its document."""
+        doc_start, doc_end = self.document_bounds(doc)
+        lo = max(doc_start, start - context)
+        hi = min(doc_end, end + context)
+        raw = self.map[self.text_start + lo:self.text_start + hi]
+        # The window may cut a multi-byte character at either edge
+        return ' '.join(raw.decode('utf-8', errors='ignore').split())
+
+    def finditer(self, pattern):
+        """Yield (doc, start, end) for matches of a compiled bytes regex."""
+        for match in pattern.finditer(self.map, self.text_start, self.text_end):
+            start = match.start() - self.text_start
+            end = match.end() - self.text_start
+            yield self.document_at(start), start, end
+
+
+def name_pattern(name):
+    """Case-insensitive bytes regex for a name as a whole-word phrase."""
+    words = [re.escape(word.encode('utf-8')) for word in name.split()]
+    return re.compile(rb'(?<!\w)' + rb'\s+'.join(words) + rb'(?!\w)', re.IGNORECASE)
+
+
+def search_corpus(corpus, name):
+    """
+    Search a local CorpusStore for a name. Returns a result dict shaped like
+    search_epstein_files results: total_hits counts matching documents and
+    hits holds a snippet around the first match in up to CORPUS_MAX_HITS
+    of them.
+    """
+    total_hits = 0
+    hits = []
+    last_doc = None
+
+    for doc, start, end in corpus.finditer(name_pattern(name)):
+        if doc == last_doc:
+            continue
+        last_doc = doc
+        total_hits += 1
+        if len(hits) < CORPUS_MAX_HITS:
+            hits.append({'content_preview': corpus.snippet(doc, start, end), 'file_path': corpus.doc_ids[doc]})
+
+    return {'total_hits': total_hits, 'hits': hits}
+
+
+def name_variants(name):
+    """
+    Spellings of a name to look up in a substring index, covering common
+    OCR and typing variants of apostrophes, hyphens and line breaks:
+    "O'Brien" also finds "O’Brien" and "OBrien", and "Smith-Jones" also
+    finds "Smith Jones".
+    """
+    variants = {name}
+    for quote in ("'", "\u2019", "`", ""):
+        variants |= {v.replace("'", quote).replace("\u2019", quote) for v in variants}
+    for hyphen in ("-", " ", ""):
+        variants |= {v.replace("-", hyphen) for v in variants if "-" in v}
+    variants |= {v.replace(" ", "\n") for v in variants if " " in v}
+    return sorted(v for v in variants if v)
+
+
+class SuffixIndex:
+    """
+    Suffix array over a CorpusStore's text, stored next to the corpus and
+    memory-mapped for queries. Counting and locating a pattern of length m
+    costs O(m log n) byte comparisons, independent of how often it occurs.
+    Matching is ASCII case-insensitive.
+    """
+
+    def __init__(self, corpus, path=None):
+        self.corpus = corpus
+        self.path = path or corpus.path + '.sa'
+        self.file = open(self.path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, size, mtime_ns, self.key_bytes, itemsize = SA_HEADER.unpack_from(self.map, 0)
+        if magic != SA_MAGIC or not self.matches_corpus(corpus, size, mtime_ns):
+            raise ValueError(f"{self.path} is not a suffix index for {corpus.path}")
+
+        self.positions = memoryview(self.map)[SA_HEADER.size:].cast('I' if itemsize == 4 else 'Q')
+
+    @staticmethod
+    def matches_corpus(corpus, size, mtime_ns):
+        stat = os.stat(corpus.path)
+        return stat.st_size == size and stat.st_mtime_ns == mtime_ns
+
+    @classmethod
+    def open_or_build(cls, corpus, path=None):
+        """Open the corpus's suffix index, building it if missing or stale. Returns (index, built)."""
+        path = path or corpus.path + '.sa'
+        if os.path.exists(path):
+            try:
+                return cls(corpus, path), False
+            except ValueError:
+                pass
+        build_suffix_index(corpus, path)
+        return cls(corpus, path), True
+
+    def close(self):
+        self.positions.release()
+        self.map.close()
+        self.file.close()
+
+    def _key(self, position, length):
+        start = self.corpus.text_start + position
+        return self.corpus.map[start:start + length].lower()
+
+    def locate(self, pattern):
+        """Return the sorted text positions where pattern (str) occurs."""
+        needle = pattern.encode('utf-8').lower()
+        prefix = needle[:self.key_bytes]
+        m = len(prefix)
+        positions = self.positions
+
+        lo, hi = 0, len(positions)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._key(positions[mid], m) < prefix:
+                lo = mid + 1
+            else:
+                hi = mid
+        first = lo
+
+        hi = len(positions)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._key(positions[mid], m) <= prefix:
+                lo = mid + 1
+            else:
+                hi = mid
+
+        found = positions[first:lo].tolist()
+        if len(needle) > m:
+            found = [p for p in found if self._key(p, len(needle)) == needle]
+        return sorted(found)
+
+    def count(self, pattern):
+        return len(self.locate(pattern))
+
+
+def build_suffix_index(corpus, path):
+    """
+    Build the suffix array for a corpus. Runs of positions are sorted by
+    their key prefix and spilled to temporary files, then merged into the
+    index, so the build never holds more than one run of keys in memory.
+    When there are more than SA_MERGE_FAN_IN runs, they are first merged
+    in groups into longer runs, so only that many files are open at once.
+    """
+    text_start = corpus.text_start
+    text = corpus.map
+    n = corpus.text_end - text_start
+    typecode = 'I' if n < 2 ** 32 else 'Q'
+
+    def key(position):
+        return text[text_start + position:text_start + position + SA_KEY_BYTES].lower()
+
+    def read_run(run_path):
+        with open(run_path, 'rb') as f:
+            while True:
+                chunk = array.array(typecode)
+                chunk.frombytes(f.read(65536 * chunk.itemsize))
+                if not chunk:
+                    return
+                yield from chunk
+
+    stat = os.stat(corpus.path)
+    tmp_dir = tempfile.mkdtemp(prefix='epsteout-sa-', dir=os.path.dirname(os.path.abspath(path)))
+    try:
+        run_paths = []
+        for run_start in range(0, n, SA_RUN_SIZE):
+            run = array.array(typecode, sorted(range(run_start, min(n, run_start + SA_RUN_SIZE)), key=key))
+            run_paths.append(os.path.join(tmp_dir, f"run{len(run_paths)}"))
+            with open(run_paths[-1], 'wb') as f:
+                run.tofile(f)
+            del run
+
+        merge_pass = 0
+        while len(run_paths) > SA_MERGE_FAN_IN:
+            merge_pass += 1
+            merged_paths = []
+            for group_start in range(0, len(run_paths), SA_MERGE_FAN_IN):
+                group = run_paths[group_start:group_start + SA_MERGE_FAN_IN]
+                merged_paths.append(os.path.join(tmp_dir, f"pass{merge_pass}-run{len(merged_paths)}"))
+                with open(merged_paths[-1], 'wb') as f:
+                    for batch in _batched(heapq.merge(*[read_run(run_path) for run_path in group], key=key), 65536):
+                        array.array(typecode, batch).tofile(f)
+                for run_path in group:
+                    os.remove(run_path)
+            run_paths = merged_paths
+
+        tmp_path = path + '.tmp'
+        with open(tmp_path, 'wb') as out:
+            out.write(SA_HEADER.pack(SA_MAGIC, stat.st_size, stat.st_mtime_ns, SA_KEY_BYTES, array.array(typecode).itemsize))
+            merged = heapq.merge(*[read_run(run_path) for run_path in run_paths], key=key)
+            for batch in _batched(merged, 65536):
+                array.array(typecode, batch).tofile(out)
+        os.replace(tmp_path, path)
+    finally:
+        for name in os.listdir(tmp_dir):
+            os.remove(os.path.join(tmp_dir, name))
+        os.rmdir(tmp_dir)
+
+
+def search_suffix_index(index, name):
+    """
+    Search a corpus through its SuffixIndex. Same result shape and
+    whole-word semantics as search_corpus, plus the spelling variants
+    from name_variants.
+    """
+    corpus = index.corpus
+    text_start = corpus.text_start
+    matches = set()
+
+    for variant in name_variants(name):
+        length = len(variant.encode('utf-8'))
+        for position in index.locate(variant):
+            # Whole words only: "Dan Brown" shouldn't match "Dan Browning"
+            before = corpus.map[text_start + position - 1:text_start + position] if position else b''
+            after = corpus.map[text_start + position + length:text_start + position + length + 1]
+            if not (before.isalnum() or after.isalnum()):
+                matches.add((position, position + length))
+
+    total_hits = 0
+    hits = []
+    last_doc = None
+    for start, end in sorted(matches):
+        doc = corpus.document_at(start)
+        if doc == last_doc:
+            continue
+        last_doc = doc
+        total_hits += 1
+        if len(hits) < CORPUS_MAX_HITS:
+            hits.append({'content_preview': corpus.snippet(doc, start, end), 'file_path': corpus.doc_ids[doc]})
+
+    return {'total_hits': total_hits, 'hits': hits}
+
+
+def benchmark_suffix_index(corpus, names, build_seconds=None):
+    """Print index size, build time and per-query latency against the regex scan."""
+    index, built = SuffixIndex.open_or_build(corpus)
+    corpus_bytes = corpus.text_end - corpus.text_start
+    index_bytes = os.path.getsize(index.path)
+
+    print(f"Corpus text:  {corpus_bytes:,} bytes in {corpus.doc_count:,} documents")
+    print(f"Suffix index: {index_bytes:,} bytes ({index_bytes / max(corpus_bytes, 1):.1f}x text)")
+    if build_seconds is not None:
+        print(f"Build time:   {build_seconds:.2f}s")
+
+    def latencies(search):
+        timings = []
+        totals = []
+        for name in names:
+            started = time.perf_counter()
+            totals.append(search(name)['total_hits'])
+            timings.append((time.perf_counter() - started) * 1000)
+        timings.sort()
+        return timings, totals
+
+    index_ms, index_totals = latencies(functools.partial(search_suffix_index, index))
+    scan_ms, scan_totals = latencies(functools.partial(search_corpus, corpus))
+
+    def pct(timings, q):
+        return timings[min(len(timings) - 1, int(q * len(timings)))]
+
+    print(f"\nQuery latency over {len(names):,} names (ms):")
+    print(f"  suffix index  p50 {pct(index_ms, 0.5):8.3f}  p95 {pct(index_ms, 0.95):8.3f}  max {index_ms[-1]:8.3f}")
+    print(f"  regex scan    p50 {pct(scan_ms, 0.5):8.3f}  p95 {pct(scan_ms, 0.95):8.3f}  max {scan_ms[-1]:8.3f}")
+
+    differing = sum(a != b for a, b in zip(index_totals, scan_totals))
+    if differing:
+        print(f"  {differing:,} names matched a different number of documents "
+              "(spelling variants, or name parts split across non-space whitespace)")
+
+
+def tokenize(text):
+    """Lower-cased ASCII word tokens of a bytes or str text."""
+    if isinstance(text, str):
+        text = text.encode('utf-8')
+    return re.findall(rb'\w+', text.lower())
+
+
+def build_token_store(corpus, path):
+    """
+    Tokenize every corpus document once into a flat array of term ids.
+    Tokens are written document by document; only the term dictionary is
+    held in memory.
+    """
+    stat = os.stat(corpus.path)
+    terms = {}
+    doc_offsets = array.array('Q', [0])
+    token_count = 0
+
+    tmp_path = path + '.tmp'
+    with open(tmp_path, 'wb') as out:
+        out.write(b'\0' * TOKEN_HEADER.size)
+
+        for doc in range(corpus.doc_count):
+            start, end = corpus.document_bounds(doc)
+            ids = array.array('I', (
+                terms.setdefault(token, len(terms))
+                for token in tokenize(corpus.map[corpus.text_start + start:corpus.text_start + end])
+            ))
+            ids.tofile(out)
+            token_count += len(ids)
+            doc_offsets.append(token_count)
+
+        out.write(b'\0' * (-out.tell() % 8))
+        doc_offsets.tofile(out)
+
+        terms_position = out.tell()
+        out.write(json.dumps([term.decode('latin-1') for term in terms]).encode('utf-8'))
+
+        out.seek(0)
+        out.write(TOKEN_HEADER.pack(TOKEN_MAGIC, stat.st_size, stat.st_mtime_ns, token_count,
+                                    corpus.doc_count, terms_position))
+    os.replace(tmp_path, path)
+
+
+class TokenStore:
+    """
+    Memory-mapped token ids of a corpus, built by build_token_store. The
+    token array is viewed in place (as a numpy array when numpy is
+    available) and never copied as a whole.
+    """
+
+    def __init__(self, corpus, path=None):
+        self.corpus = corpus
+        self.path = path or corpus.path + '.tok'
+        self.file = open(self.path, 'rb')
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, size, mtime_ns, self.token_count, doc_count, terms_position = TOKEN_HEADER.unpack_from(self.map, 0)
+        if magic != TOKEN_MAGIC or not SuffixIndex.matches_corpus(corpus, size, mtime_ns):
+            raise ValueError(f"{self.path} is not a token store for {corpus.path}")
+
+        tokens_end = TOKEN_HEADER.size + 4 * self.token_count
+        offsets_start = tokens_end + (-tokens_end % 8)
+        self.tokens = memoryview(self.map)[TOKEN_HEADER.size:tokens_end].cast('I')
+        self.doc_offsets = memoryview(self.map)[offsets_start:offsets_start + 8 * (doc_count + 1)].cast('Q')
+        terms = json.loads(self.map[terms_position:].decode('utf-8'))
+        self.term_ids = {term.encode('latin-1'): i for i, term in enumerate(terms)}
+
+    @classmethod
+    def open_or_build(cls, corpus, path=None):
+        """Open the corpus's token store, building it if missing or stale."""
+        path = path or corpus.path + '.tok'
+        if os.path.exists(path):
+            try:
+                return cls(corpus, path)
+            except ValueError:
+                pass
+        build_token_store(corpus, path)
+        return cls(corpus, path)
+
+    def term_sequence(self, name):
+        """Term ids of a name, or None if any of its words never occurs."""
+        ids = [self.term_ids.get(token) for token in tokenize(name)]
+        return None if not ids or None in ids else ids
+
+    def bigram_positions(self, bigrams):
+        """
+        Yield (token position, bigram key) for every adjacent token pair in
+        the corpus whose key ((first id << 32) | second id) is in the sorted
+        sequence bigrams. Pairs spanning two documents are skipped.
+        With numpy this is a chunked, vectorized hash join: keys for a chunk
+        of pairs are built with array shifts and looked up with a sorted
+        searchsorted; without numpy it falls back to a Python set lookup.
+        """
+        n = self.token_count
+        if n < 2 or not bigrams:
+            return
+
+        if HAS_NUMPY:
+            np = numpy
+            tokens = np.frombuffer(self.tokens, dtype=np.uint32)
+            wanted = np.frombuffer(bigrams, dtype=np.uint64)
+            doc_starts = np.frombuffer(self.doc_offsets, dtype=np.uint64)[1:-1].astype(np.int64)
+            for chunk_start in range(0, n - 1, BIGRAM_CHUNK_TOKENS):
+                chunk_end = min(n - 1, chunk_start + BIGRAM_CHUNK_TOKENS)
+                keys = (tokens[chunk_start:chunk_end].astype(np.uint64) << np.uint64(32)) \
+                    | tokens[chunk_start + 1:chunk_end + 1].astype(np.uint64)
+                slots = np.minimum(np.searchsorted(wanted, keys), len(wanted) - 1)
+                found = wanted[slots] == keys
+                # A pair whose second token starts a document spans two documents
+                starts = doc_starts[(doc_starts > chunk_start) & (doc_starts <= chunk_end)]
+                found[starts - chunk_start - 1] = False
+                matched = np.nonzero(found)[0]
+                for offset, key in zip(matched.tolist(), keys[matched].tolist()):
+                    yield chunk_start + offset, key
+        else:
+            bigrams = set(bigrams)
+            tokens = self.tokens
+            doc_starts = iter(self.doc_offsets[1:])
+            next_doc_start = next(doc_starts)
+            previous = tokens[0]
+            for position in range(1, n):
+                current = tokens[position]
+                while next_doc_start < position:
+                    next_doc_start = next(doc_starts)
+                key = (previous << 32) | current
+                if key in bigrams and position != next_doc_start:
+                    yield position - 1, key
+                previous = current
+
+    def document_at(self, token_position):
+        return bisect.bisect_right(self.doc_offsets, token_position, 0, len(self.doc_offsets) - 1) - 1
+
+
+def matcher_key(name):
+    """Token-normalized form of a name, as the compiled matcher stores it."""
+    return ' '.join(token.decode('ascii') for token in tokenize(name))
+
+
+def contact_set_digest(keys):
+    return hashlib.sha256('\n'.join(sorted(keys)).encode('utf-8')).digest()
+
+
+def write_matcher(path, store, entries, names):
+    """
+    Write a compiled matcher: (bigram key, contact id) entries sorted by key,
+    then the contact list as [[name key, term ids], ...] indexed by id.
+    """
+    size, mtime_ns = TOKEN_HEADER.unpack_from(store.map, 0)[1:3]
+    keys = array.array('Q')
+    ids = array.array('I')
+    for key, contact_id in entries:
+        keys.append(key)
+        ids.append(contact_id)
+
+    tmp_path = path + '.tmp'
+    with open(tmp_path, 'wb') as out:
+        out.write(b'\0' * MATCHER_HEADER.size)
+        keys.tofile(out)
+        ids.tofile(out)
+        names_position = out.tell()
+        out.write(json.dumps(names).encode('utf-8'))
+        out.seek(0)
+        out.write(MATCHER_HEADER.pack(MATCHER_MAGIC, size, mtime_ns,
+                                      contact_set_digest(name for name, _ in names), len(keys), names_position))
+    os.replace(tmp_path, path)
+
+
+class BigramMatcher:
+    """
+    Compiled bigram table for a contact list over one token store, persisted
+    next to it (<corpus>.match) and memory-mapped on later runs. Each
+    contact's first two term ids form a (first << 32 | second) key; keys are
+    kept sorted with a parallel array of contact ids.
+    """
+
+    def __init__(self, store, path):
+        self.path = path
+        with open(path, 'rb') as f:
+            self.map = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+        magic, size, mtime_ns, self.digest, count, names_position = MATCHER_HEADER.unpack_from(self.map, 0)
+        if magic != MATCHER_MAGIC or (size, mtime_ns) != TOKEN_HEADER.unpack_from(store.map, 0)[1:3]:
+            raise ValueError(f"{path} is not a matcher for {store.path}")
+
+        keys_end = MATCHER_HEADER.size + 8 * count
+        self.keys = memoryview(self.map)[MATCHER_HEADER.size:keys_end].cast('Q')
+        self.contact_ids = memoryview(self.map)[keys_end:keys_end + 4 * count].cast('I')
+        self.names = json.loads(self.map[names_position:].decode('utf-8'))
+
+    @classmethod
+    def load_or_compile(cls, store, name_keys, path=None):
+        """
+        Return (matcher, status) for the given name keys. A stored matcher
+        that already covers them is used as is ('loaded'). If it only lacks
+        some names, just those are compiled and merged into the sorted table
+        ('extended'). Once more than half of the stored contacts are gone,
+        it is compiled from scratch.
+        """
+        path = path or store.corpus.path + '.match'
+        name_keys = set(name_keys)
+        matcher = None
+        if os.path.exists(path):
+            try:
+                matcher = cls(store, path)
+            except ValueError:
+                pass
+
+        if matcher is not None and matcher.digest == contact_set_digest(name_keys):
+            return matcher, 'loaded'
+
+        known = {name for name, _ in matcher.names} if matcher is not None else set()
+        if matcher is not None and 2 * len(known - name_keys) <= len(known):
+            if name_keys <= known:
+                return matcher, 'loaded'
+            names = matcher.names
+            existing = zip(matcher.keys, matcher.contact_ids)
+            status = 'extended'
+        else:
+            names, existing, status = [], (), 'compiled'
+
+        added = []
+        for name in sorted(name_keys - known) if status == 'extended' else sorted(name_keys):
+            ids = store.term_sequence(name)
+            contact_id = len(names)
+            names.append([name, ids])
+            if ids is not None and len(ids) >= 2:
+                added.append(((ids[0] << 32) | ids[1], contact_id))
+        added.sort()
+
+        entries = list(heapq.merge(existing, added))
+        if matcher is not None:
+            matcher.close()
+        write_matcher(path, store, entries, names)
+        return cls(store, path), status
+
+    def close(self):
+        self.keys.release()
+        self.contact_ids.release()
+        self.map.close()
+
+    def contacts_for(self, key):
+        """Contact ids whose bigram is key."""
+        start = bisect.bisect_left(self.keys, key)
+        end = bisect.bisect_right(self.keys, key, start)
+        return self.contact_ids[start:end]
+
+
+def match_contacts_bigram(store, matcher, names):
+    """
+    Match every name against the corpus in a single pass over the token
+    array, joining all of the matcher's bigram keys against the corpus's
+    adjacent token pairs at once. Words beyond the first two are checked at
+    the matched positions. Returns {name: result dict} shaped like
+    search_corpus results.
+    """
+    corpus = store.corpus
+    by_key = {}
+    for name in names:
+        by_key.setdefault(matcher_key(name), []).append(name)
+
+    matched_docs = {}
+    tokens = store.tokens
+    for position, key in store.bigram_positions(matcher.keys):
+        for contact_id in matcher.contacts_for(key):
+            name_key, ids = matcher.names[contact_id]
+            if name_key not in by_key:
+                continue
+            doc = store.document_at(position)
+            if len(ids) > 2 and (position + len(ids) > store.doc_offsets[doc + 1]
+                                 or tokens[position + 2:position + len(ids)].tolist() != ids[2:]):
+                continue
+            docs = matched_docs.setdefault(name_key, [])
+            if not docs or docs[-1] != doc:
+                docs.append(doc)
+
+    results = {}
+    for name_key, originals in by_key.items():
+        docs = matched_docs.get(name_key, [])
+        hits = []
+        if docs:
+            pattern = name_pattern(originals[0])
+            for doc in docs[:CORPUS_MAX_HITS]:
+                start, end = corpus.document_bounds(doc)
+                match = pattern.search(corpus.map, corpus.text_start + start, corpus.text_start + end)
+                if match:
+                    hit_start, hit_end = match.start() - corpus.text_start, match.end() - corpus.text_start
+                    preview = corpus.snippet(doc, hit_start, hit_end)
+                else:
+                    # Matched across punctuation the phrase regex doesn't allow
+                    preview = corpus.snippet(doc, start, start)
+                hits.append({'content_preview': preview, 'file_path': corpus.doc_ids[doc]})
+        for name in originals:
+            results[name] = {'total_hits': len(docs), 'hits': hits}
+
+    return results
+
+
+class SearchPool:
+    """
+    Worker threads that run searches concurrently, against the API or, when
+    backend is given, a local callable taking a name and returning a result
+    dict. Results are handed back to the calling thread, which owns the
+    cache, so cache writes are never interleaved. Workers are daemon
+    threads: a shutdown deadline can abandon requests still in flight
+    without blocking interpreter exit.
+    """
+
+    def __init__(self, workers, api_key, api_url, stop_event, request_log=None, tracer=NULL_TRACER,
+                 limiter=None, backend=None):
+        self.backend = backend
+        self.api_key = api_key
+        self.api_url = api_url
+        self.stop_event = stop_event
+        self.request_log = request_log
+        self.tracer = tracer
+        self.limiter = limiter
+        self.jobs = queue.Queue()
+        self.results = queue.Queue()
+        self.in_flight = 0
+        self.workers = workers
+
+        for _ in range(workers):
+            threading.Thread(target=self._work, daemon=True).start()
+
+    def submit(self, position, contact, cached_entry, delay):
+        self.in_flight += 1
+        self.jobs.put((position, contact, cached_entry, delay))
+
+    def get(self, timeout):
+        """
+        Return the next (position, contact, result, delay, sampled), or None on
+        timeout. sampled says whether the search was traced, so its cache
+        flush can be too.
+        """
+        try:
+            item = self.results.get(timeout=max(timeout, 0))
+        except queue.Empty:
+            return None
+        self.in_flight -= 1
+        return item
+
+    def close(self):
+        """Let the workers exit once the jobs already submitted are done."""
+        for _ in range(self.workers):
+            self.jobs.put(None)
+
+    def _work(self):
+        while True:
+            job = self.jobs.get()
+            if job is None:
+                return
+            position, contact, cached_entry, delay = job
+
+            if self.stop_event.is_set():
+                # Queued but not started before shutdown
+                self.results.put((position, contact, {'cancelled': True}, delay, False))
+                continue
+
+            sampled = self.tracer.sampled()
+            tracer = self.tracer if sampled else NULL_TRACER
+            try:
+                with tracer.span('search', contact=contact['full_name']) as span_args:
+                    if self.backend is not None:
+                        result = self.backend(contact['full_name'])
+                    else:
+                        result, delay = search_epstein_files(
+                            contact['full_name'], delay, self.api_key, validators=cached_entry,
+                            api_url=self.api_url, stop_event=self.stop_event,
+                            request_log=self.request_log, tracer=tracer, limiter=self.limiter
+                        )
+                    span_args['total_hits'] = result.get('total_hits')
+            except Exception as e:
+                result = {'total_hits': 0, 'hits': [], 'error': str(e)}
+            self.results.put((position, contact, result, delay, sampled))
+
+            # Rate limiting: each worker waits before taking its next API
+            # search, unless the shared limiter paces requests instead
+            if self.backend is None and self.limiter is None:
+                self.stop_event.wait(delay)
+
+
+class Shutdown:
+    """
+    Ctrl+C handling. The first interrupt stops dispatching new searches and
+    gives in-flight ones `timeout` seconds to finish; a second one exits
+    immediately (the cache is always replaced atomically, so it stays intact).
+    """
+
+    def __init__(self, timeout):
+        self.timeout = timeout
+        self.stop_event = threading.Event()
+        self.requested_at = None
+
+    def install(self):
+        signal.signal(signal.SIGINT, self._handle)
+
+    def _handle(self, signum, frame):
+        if self.stop_event.is_set():
+            print("\nSecond Ctrl+C: exiting immediately.", flush=True)
+            os._exit(130)
+
+        self.requested_at = time.monotonic()
+        self.stop_event.set()
+        print("\n\nSearch interrupted by user (Ctrl+C). Finishing in-flight searches "
+              f"(up to {self.timeout:g}s); press Ctrl+C again to exit immediately.", flush=True)
+
+    @property
+    def deadline(self):
+        return self.requested_at + self.timeout
+
+
+def unchanged_result(cached_entry):
+    """The search result for a 304: the cached hits and validators."""
+    return {
+        'total_hits': cached_entry['total_hits'],
+        'hits': entry_hits(cached_entry),
+        'etag': cached_entry.get('etag'),
+        'last_modified': cached_entry.get('last_modified'),
+    }
+
+
+def make_cache_entry(contact, search_result):
+    """The cache entry recording a contact's search result, including its error if the search failed."""
+    entry = {
+        'last_searched': datetime.now().isoformat(),
+        'total_hits': search_result['total_hits'],
+        'hits_z': compress_hits(search_result['hits']),
+        'etag': search_result.get('etag'),
+        'last_modified': search_result.get('last_modified'),
+        'first_name': contact['first_name'],
+        'last_name': contact['last_name'],
+        'company': contact['company'],
+        'position': contact['position'],
+        'source': contact.get('source', 'connections'),
+    }
+    if 'error' in search_result:
+        entry['error'] = search_result['error']
+    return entry
+
+
+def run_searches(contacts, planned, progress, cache, api_key, args, shutdown, request_log=None,
+                 tracer=NULL_TRACER, watched=(), history=None, backend=None):
+    """
+    Search the planned contacts (indexes into contacts), args.workers at a
+    time, starting from checkpointed progress {'cursor', 'delay',
+    'done_ahead'}. Each result is written to the cache as it arrives.
+
+    watched contacts (indexes) get a priority lane: whenever one is due
+    (older than args.watchlist_ttl_hours), it is searched ahead of the
+    remaining planned work, for as long as the run lasts.
+
+    Changes in each contact's results are appended to history, a
+    HistoryStore, when given. backend replaces the API with a local search
+    (see SearchPool).
+
+    Returns (names searched this run, number of searches, watchlist
+    changes as (name, previous total, new total) tuples).
+    """
+    cursor = progress['cursor']
+    delay = progress['delay']
+    completed = set(progress['done_ahead'])
+    searched_this_run = set()
+    search_count = 0
+    watch_changes = []
+
+    # Priority lane: (due timestamp, contact index) for watched contacts
+    watch_ttl = args.watchlist_ttl_hours * 3600
+    watch_lane = []
+    for i in watched:
+        cached_entry = cache.get(contacts[i]['full_name'])
+        due = 0.0
+        if cached_entry and 'last_searched' in cached_entry:
+            due = datetime.fromisoformat(cached_entry['last_searched']).timestamp() + watch_ttl
+        watch_lane.append((due, i))
+    heapq.heapify(watch_lane)
+
+    limiter = SharedRateLimiter(api_key, args.shared_rate_limit) if args.shared_rate_limit and backend is None else None
+    pool = SearchPool(args.workers, api_key, args.api_url, shutdown.stop_event, request_log, tracer, limiter,
+                      backend)
+    next_position = cursor
+
+    while True:
+        stopping = shutdown.stop_event.is_set()
+
+        if not stopping:
+            while pool.in_flight < args.workers:
+                # Due watchlist contacts preempt bulk work
+                if watch_lane and watch_lane[0][0] <= time.time():
+                    _, i = heapq.heappop(watch_lane)
+                    contact = contacts[i]
+                    pool.submit(('watch', i), contact, cache.get(contact['full_name']), delay)
+                    continue
+
+                while next_position in completed:
+                    next_position += 1
+                if next_position >= len(planned):
+                    break
+                contact = contacts[planned[next_position]]
+                pool.submit(next_position, contact, cache.get(contact['full_name']), delay)
+                next_position += 1
+
+        # The run ends with the planned work; future watchlist refreshes
+        # belong to the next run.
+        if pool.in_flight == 0:
+            break
+
+        if stopping:
+            remaining = shutdown.deadline - time.monotonic()
+            if remaining <= 0:
+                break
+            item = pool.get(min(remaining, 0.5))
+        else:
+            item = pool.get(0.5)
+
+        if item is None:
+            continue
+
+        position, contact, search_result, delay, sampled = item
+        from_watch_lane = isinstance(position, tuple)
+        if from_watch_lane:
+            progress_label = f"  [watchlist] {contact['full_name']}"
+        else:
+            progress_label = f"  [{position+1}/{len(planned)}] {contact['full_name']}"
+
+        if search_result.get('cancelled'):
+            print(f"{progress_label} -> cancelled")
+            continue
+
+        cached_entry = cache.get(contact['full_name'])
+        status = ''
+        if search_result.get('not_modified'):
+            search_result = unchanged_result(cached_entry)
+            status = ' (not modified)'
+
+        total_mentions = search_result['total_hits']
+
+        print(f"{progress_label} -> {total_mentions} hits{status}")
+
+        if from_watch_lane:
+            previous_total = cached_entry['total_hits'] if cached_entry else None
+            if previous_total != total_mentions and (previous_total is not None or total_mentions > 0):
+                watch_changes.append((contact['full_name'], previous_total, total_mentions))
+                print(f"  ! Watchlist change: {contact['full_name']} {previous_total or 0} -> {total_mentions} mentions")
+                if request_log is not None:
+                    request_log.write({'event': 'watchlist_change', 'contact': contact['full_name'],
+                                       'previous_total_hits': previous_total, 'total_hits': total_mentions})
+            heapq.heappush(watch_lane, (time.time() + watch_ttl, position[1]))
+
+        if history is not None and 'error' not in search_result:
+            history.record(contact['full_name'], total_mentions, search_result['hits'])
+
+        # Update cache immediately so interrupted runs keep progress
+        with tracer.span('cache_flush', enabled=sampled), locked_file(CACHE_PATH + '.lock'):
+            # Another process may have trained (and replaced) the dictionary
+            reload_hit_codec()
+            cache[contact['full_name']] = make_cache_entry(contact, search_result)
+            save_cache(cache)
+        searched_this_run.add(contact['full_name'])
+        search_count += 1
+
+        if not from_watch_lane:
+            completed.add(position)
+            while cursor in completed:
+                completed.remove(cursor)
+                cursor += 1
+            save_checkpoint_cursor(cursor, delay, sorted(completed))
+
+    pool.close()
+    if pool.in_flight:
+        print(f"\nAbandoned {pool.in_flight} in-flight searches at the shutdown deadline; "
+              "rerun with --resume to retry them.")
+
+    if cursor >= len(planned):
+        clear_checkpoint()
+
+    return searched_this_run, search_count, watch_changes
+
+
+class WorkQueue:
+    """
+    Durable job queue in a SQLite file, shared by any number of worker
+    processes (--queue). Workers lease one job at a time for
+    QUEUE_LEASE_SECONDS and extend their leases with heartbeats while the
+    search runs. A job whose lease expires, because its worker died or
+    stalled, is handed to the next worker that asks. Failed searches are
+    retried up to QUEUE_MAX_ATTEMPTS times.
+    """
+
+    def __init__(self, path, lease_seconds=QUEUE_LEASE_SECONDS):
+        self.path = path
+        self.lease_seconds = lease_seconds
+        self.owner = f"{os.getpid()}-{random.getrandbits(32):08x}"
+        self.db = self._connect()
+        self.db.executescript("""
+            CREATE TABLE IF NOT EXISTS jobs (
+                id INTEGER PRIMARY KEY,
+                contact TEXT NOT NULL,
+                state TEXT NOT NULL DEFAULT 'pending',
+                owner TEXT,
+                lease_expires REAL,
+                attempts INTEGER NOT NULL DEFAULT 0,
+                error TEXT
+            );
+            CREATE INDEX IF NOT EXISTS jobs_state ON jobs (state, id);
+        """)
+
+    def _connect(self):
+        # Autocommit; writes take the database lock with BEGIN IMMEDIATE
+        db = sqlite3.connect(self.path, timeout=30, isolation_level=None)
+        db.execute('PRAGMA journal_mode=WAL')
+        return db
+
+    @contextlib.contextmanager
+    def _transaction(self, db=None):
+        db = db or self.db
+        db.execute('BEGIN IMMEDIATE')
+        try:
+            yield db
+        except BaseException:
+            db.execute('ROLLBACK')
+            raise
+        db.execute('COMMIT')
+
+    def seed(self, contacts):
+        """
+        Queue contacts unless the queue still has open work, in which case
+        this process joins it instead. Returns the number of jobs added.
+        """
+        with self._transaction() as db:
+            if db.execute("SELECT 1 FROM jobs WHERE state IN ('pending', 'leased') LIMIT 1").fetchone():
+                return 0
+            db.execute('DELETE FROM jobs')
+            rows = [(json.dumps(contact, ensure_ascii=False),) for contact in contacts]
+            db.executemany('INSERT INTO jobs (contact) VALUES (?)', rows)
+        return len(rows)
+
+    def lease(self):
+        """Lease the next pending or expired job; returns (job id, contact) or None."""
+        while True:
+            now = time.time()
+            with self._transaction() as db:
+                row = db.execute(
+                    "SELECT id, contact, attempts FROM jobs"
+                    " WHERE state = 'pending' OR (state = 'leased' AND lease_expires < ?)"
+                    " ORDER BY id LIMIT 1", (now,)
+                ).fetchone()
+                if row is None:
+                    return None
+                job_id, contact, attempts = row
+                if attempts >= QUEUE_MAX_ATTEMPTS:
+                    # Its workers keep dying on it; stop handing it out
+                    db.execute("UPDATE jobs SET state = 'failed', owner = NULL,"
+                               " error = coalesce(error, 'lease expired') WHERE id = ?", (job_id,))
+                    continue
+                db.execute("UPDATE jobs SET state = 'leased', owner = ?, lease_expires = ?,"
+                           " attempts = attempts + 1 WHERE id = ?",
+                           (self.owner, now + self.lease_seconds, job_id))
+            return job_id, json.loads(contact)
+
+    def complete(self, job_id):
+        with self._transaction() as db:
+            db.execute("UPDATE jobs SET state = 'done', owner = NULL, error = NULL WHERE id = ?", (job_id,))
+
+    def fail(self, job_id, error):
+        """Put a failed job back for another attempt, or give up on it."""
+        with self._transaction() as db:
+            db.execute("UPDATE jobs SET state = CASE WHEN attempts >= ? THEN 'failed' ELSE 'pending' END,"
+                       " owner = NULL, error = ? WHERE id = ? AND owner = ?",
+                       (QUEUE_MAX_ATTEMPTS, error, job_id, self.owner))
+
+    def release(self, job_id):
+        """Hand back a job this worker didn't get to search, without counting an attempt."""
+        with self._transaction() as db:
+            db.execute("UPDATE jobs SET state = 'pending', owner = NULL, attempts = attempts - 1"
+                       " WHERE id = ? AND owner = ? AND state = 'leased'", (job_id, self.owner))
+
+    def counts(self):
+        """Map each job state to its number of jobs."""
+        return dict(self.db.execute('SELECT state, COUNT(*) FROM jobs GROUP BY state'))
+
+    def start_heartbeat(self, stop_event):
+        """Extend this worker's leases every third of the lease period until stop_event is set."""
+        def beat():
+            db = self._connect()
+            while not stop_event.wait(self.lease_seconds / 3):
+                with self._transaction(db):
+                    db.execute("UPDATE jobs SET lease_expires = ? WHERE owner = ? AND state = 'leased'",
+                               (time.time() + self.lease_seconds, self.owner))
+            db.close()
+
+        thread = threading.Thread(target=beat, name='queue-heartbeat', daemon=True)
+        thread.start()
+        return thread
+
+
+def run_queue_worker(queue, cache, api_key, args, shutdown, request_log=None, tracer=NULL_TRACER,
+                     history=None, backend=None):
+    """
+    Lease and search jobs from a WorkQueue, args.workers at a time, until
+    it has no open jobs left. Each result is merged into the shared cache
+    file under a lock, so concurrent workers never lose each other's
+    results, and cache is refreshed with everything they found.
+    Returns (names searched by this worker, number of searches).
+    """
+    searched_this_run = set()
+    search_count = 0
+    delay = 0.25
+    in_flight = set()
+
+    limiter = SharedRateLimiter(api_key, args.shared_rate_limit) if args.shared_rate_limit and backend is None else None
+    pool = SearchPool(args.workers, api_key, args.api_url, shutdown.stop_event, request_log, tracer, limiter,
+                      backend)
+    heartbeat_stop = threading.Event()
+    queue.start_heartbeat(heartbeat_stop)
+
+    try:
+        while True:
+            stopping = shutdown.stop_event.is_set()
+
+            while not stopping and len(in_flight) < args.workers:
+                job = queue.lease()
+                if job is None:
+                    break
+                job_id, contact = job
+                in_flight.add(job_id)
+                pool.submit(job_id, contact, cache.get(contact['full_name']), delay)
+
+            if not in_flight:
+                counts = queue.counts()
+                if stopping or not counts.get('leased'):
+                    break
+                # Other workers hold the last leases; wait in case one expires
+                shutdown.stop_event.wait(QUEUE_POLL_SECONDS)
+                continue
+
+            if stopping and time.monotonic() >= shutdown.deadline:
+                break
+            item = pool.get(0.5)
+            if item is None:
+                continue
+
+            job_id, contact, search_result, delay, sampled = item
+            in_flight.discard(job_id)
+            name = contact['full_name']
+
+            if search_result.get('cancelled'):
+                queue.release(job_id)
+                print(f"  [job {job_id}] {name} -> cancelled")
+                continue
+            if 'error' in search_result:
+                queue.fail(job_id, search_result['error'])
+                print(f"  [job {job_id}] {name} -> error: {search_result['error']}")
+                continue
+
+            with tracer.span('cache_flush', enabled=sampled), locked_file(CACHE_PATH + '.lock'):
+                # Another worker may have trained (and replaced) the dictionary
+                reload_hit_codec()
+                shared = load_cache()
+                cached_entry = shared.get(name)
+                status = ''
+                if search_result.get('not_modified'):
+                    search_result = unchanged_result(cached_entry)
+                    status = ' (not modified)'
+                if history is not None:
+                    history.record(name, search_result['total_hits'], search_result['hits'])
+                shared[name] = make_cache_entry(contact, search_result)
+                save_cache(shared)
+            cache.update(shared)
+            queue.complete(job_id)
+
+            print(f"  [job {job_id}] {name} -> {search_result['total_hits']} hits{status}")
+            searched_this_run.add(name)
+            search_count += 1
+    finally:
+        pool.close()
+        heartbeat_stop.set()
+        for job_id in in_flight:
+            queue.release(job_id)
+
+    counts = queue.counts()
+    print(f"\nQueue: {counts.get('done', 0)} done, {counts.get('pending', 0) + counts.get('leased', 0)} open, "
+          f"{counts.get('failed', 0)} failed")
+    return searched_this_run, search_count
+
+
+def build_result(name, entry, dedup=True, history=None):
+    """
+    Turn a cache entry into a report result, clustering near-duplicate hits.
+    history is the contact's [(timestamp, total_hits), ...] series, if any.
+    """
+    hits = entry_hits(entry)
+    if dedup and len(hits) > 1:
+        clusters = cluster_near_duplicates(hits)
+    else:
+        clusters = [[hit] for hit in hits]
+
+    # Duplicates seen among the returned hits are subtracted from the
+    # API's total; hits beyond the returned page can't be compared.
+    duplicates = len(hits) - len(clusters)
+
+    return {
+        'name': name,
+        'first_name': entry['first_name'],
+        'last_name': entry['last_name'],
+        'company': entry['company'],
+        'position': entry['position'],
+        'source': entry.get('source', 'connections'),
+        'total_mentions': entry['total_hits'],
+        'unique_mentions': max(entry['total_hits'] - duplicates, 0),
+        'hits': hits,
+        'clusters': clusters,
+        'history': history or [],
+    }
+
+
+def hit_text(hit):
+    """Return the preview text shown for a hit."""
+    return hit.get('content_preview') or (hit.get('content') or '')[:500]
+
+
+def minhash_signature(text):
+    """
+    Compute a MinHash signature over the word shingles of a text.
+    Returns None for texts too short to sketch.
+    """
+    words = re.findall(r'\w+', text.lower())
+    if not words:
+        return None
+
+    size = min(MINHASH_SHINGLE_WORDS, len(words))
+    shingles = {
+        int.from_bytes(
+            hashlib.blake2b(' '.join(words[i:i + size]).encode('utf-8'), digest_size=8).digest(),
+            'little',
+        )
+        for i in range(len(words) - size + 1)
+    }
+
+    if HAS_NUMPY:
+        hashes = numpy.fromiter(shingles, dtype=numpy.uint64, count=len(shingles))
+        return tuple((hashes ^ _MINHASH_MASK_ARRAY).min(axis=1).tolist())
+    return tuple(min(map(mask.__xor__, shingles)) for mask in _MINHASH_MASKS)
+
+
+def cluster_near_duplicates(hits):
+    """
+    Group near-duplicate hits (re-OCR'd scans, the same thread in several
+    productions) using MinHash + LSH.
+    Returns a list of clusters, each a list of hits with the representative
+    first. Clusters and their members keep the API's ranking order.
+    """
+    signatures = [minhash_signature(hit_text(hit)) for hit in hits]
+    parent = list(range(len(hits)))
+
+    def find(i):
+        while parent[i] != i:
+            parent[i] = parent[parent[i]]
+            i = parent[i]
+        return i
+
+    rows = MINHASH_PERMUTATIONS // MINHASH_BANDS
+    for band in range(MINHASH_BANDS):
+        buckets = {}
+        for i, sig in enumerate(signatures):
+            if sig is None:
+                continue
+            buckets.setdefault(sig[band * rows:(band + 1) * rows], []).append(i)
+
+        for members in buckets.values():
+            first = members[0]
+            for other in members[1:]:
+                root_a, root_b = find(first), find(other)
+                if root_a == root_b:
+                    continue
+                agree = sum(x == y for x, y in zip(signatures[first], signatures[other]))
+                if agree >= NEAR_DUPLICATE_THRESHOLD * MINHASH_PERMUTATIONS:
+                    # Keep the lower (better-ranked) index as the root
+                    parent[max(root_a, root_b)] = min(root_a, root_b)
+
+    clusters = {}
+    for i, hit in enumerate(hits):
+        clusters.setdefault(find(i), []).append(hit)
+
+    return [clusters[root] for root in sorted(clusters)]
+
+
+def annotate_connections(csv_path, cache, output_path):
+    """
+    Copy a connections CSV to output_path with ANNOTATION_COLUMNS appended,
+    in one streaming pass. The notes preamble, header and rows are copied
+    byte for byte, with the new fields added at the end of each record;
+    each row is joined against the cache by the same name key a search
+    would use. Contacts never searched get empty annotations, and contacts
+    whose last search failed get "error" in place of a mention count.
+    Returns (rows written, rows with a cache entry).
+    """
+    rows = annotated = 0
+
+    with open(csv_path, 'rb') as f:
+        encoding = 'utf-8-sig' if f.read(3) == b'\xef\xbb\xbf' else 'utf-8'
+
+    def fields(values):
+        buffer = io.StringIO()
+        csv.writer(buffer, lineterminator='').writerow(values)
+        return ',' + buffer.getvalue()
+
+    def split_terminator(record):
+        body = record.rstrip('\r\n')
+        return body, record[len(body):]
+
+    def records(lines):
+        """Group lines into CSV records; a quoted field can span lines."""
+        record = ''
+        for line in lines:
+            record += line
+            if record.count('"') % 2 == 0:
+                yield record
+                record = ''
+        if record:
+            yield record
+
+    with open(csv_path, 'r', encoding=encoding, newline='') as f, \
+            open(output_path, 'w', encoding=encoding, newline='') as out:
+        # Copy the notes preamble through unchanged
+        header_line = None
+        for line in f:
+            if 'First Name' in line and 'Last Name' in line:
+                header_line = line
+                break
+            out.write(line)
+
+        if not header_line:
+            return rows, annotated
+
+        header = next(csv.reader([header_line]))
+        body, terminator = split_terminator(header_line)
+        out.write(body + fields(ANNOTATION_COLUMNS) + terminator)
+
+        for record in records(f):
+            body, terminator = split_terminator(record)
+            if not body:
+                out.write(record)
+                continue
+            row = next(csv.reader([body]))
+            row += [''] * (len(header) - len(row))
+            contact = _contact_from_row(dict(zip(header, row)))
+            entry = cache.get(contact['full_name']) if contact else None
+
+            if entry and 'error' in entry:
+                annotation = ['error', '', entry.get('last_searched', '')]
+                annotated += 1
+            elif entry:
+                hits = entry_hits(entry)
+                annotation = [
+                    entry.get('total_hits', 0),
+                    hit_pdf_url(hits[0]) if hits else '',
+                    entry.get('last_searched', ''),
+                ]
+                annotated += 1
+            else:
+                annotation = [''] * len(ANNOTATION_COLUMNS)
+            out.write(body + fields(annotation) + terminator)
+            rows += 1
+
+    return rows, annotated
+
+
+def hit_pdf_url(hit):
+    """Return the justice.gov PDF URL for a hit, or '' if unknown."""
+    pdf_url = hit.get('doj_url', '')
+
+    if not pdf_url:
+        file_path = hit.get('file_path', '')
+        if file_path:
+            file_path = file_path.replace('dataset', 'DataSet')
+            base_url = PDF_BASE_URL.rstrip('/') if file_path.startswith('/') else PDF_BASE_URL
+            pdf_url = base_url + urllib.parse.quote(file_path, safe='/')
+
+    return pdf_url
+
+
+def render_hit(hit):
+    """Render a single hit as an HTML fragment."""
+    preview = hit_text(hit)
+    pdf_url = hit_pdf_url(hit)
+
+    return f"""
+        <div class="hit">
+            <div class="hit-preview">{html.escape(preview)}</div>
+            {f'<a class="hit-link" href="{html.escape(pdf_url)}" target="_blank">View PDF: {html.escape(pdf_url)}</a>' if pdf_url else ''}
+        </div>
+"""
+
+
+def _batched(iterable, size):
+    """Yield lists of up to `size` items from an iterable."""
+    iterator = iter(iterable)
+    while True:
+        batch = list(itertools.islice(iterator, size))
+        if not batch:
+            return
+        yield batch
+
+
+def _export_rows(cache):
+    """
+    Flatten the cache into normalized (contacts, searches, hits) row streams.
+    Contact ids are assigned in cache order, starting at 1.
+    """
+    def contacts():
+        for contact_id, (name, entry) in enumerate(cache.items(), 1):
+            yield (contact_id, name, entry.get('first_name', ''), entry.get('last_name', ''),
+                   entry.get('company', ''), entry.get('position', ''), entry.get('source', 'connections'))
+
+    def searches():
+        for contact_id, entry in enumerate(cache.values(), 1):
+            yield (contact_id, entry.get('last_searched'), entry.get('total_hits', 0), entry.get('error'))
+
+    def hits():
+        for contact_id, entry in enumerate(cache.values(), 1):
+            for rank, hit in enumerate(entry_hits(entry), 1):
+                yield (contact_id, rank, hit.get('file_path', ''), hit_pdf_url(hit), hit_text(hit))
+
+    return contacts, searches, hits
+
+
+def is_sqlite_export(path):
+    """Whether path is a database written by export_sqlite."""
+    try:
+        conn = sqlite3.connect(f"file:{urllib.parse.quote(os.path.abspath(path))}?mode=ro", uri=True)
+    except sqlite3.Error:
+        return False
+    try:
+        tables = {row[0] for row in conn.execute("SELECT name FROM sqlite_master WHERE type = 'table'")}
+    except sqlite3.DatabaseError:
+        return False
+    finally:
+        conn.close()
+    return {'contacts', 'searches', 'hits'} <= tables
+
+
+def export_sqlite(cache, output_path, force=False):
+    """
+    Export cached results into normalized, indexed SQLite tables. An existing
+    file is only replaced if it's a previous export, or with force.
+    """
+    if os.path.exists(output_path):
+        if not force and not is_sqlite_export(output_path):
+            print(f"Error: {output_path} exists and isn't a previous export; use --force to overwrite it",
+                  file=sys.stderr)
+            sys.exit(1)
+        os.remove(output_path)
+
+    contacts, searches, hits = _export_rows(cache)
+
+    conn = sqlite3.connect(output_path)
+    try:
+        conn.executescript("""
+            CREATE TABLE contacts (
+                id INTEGER PRIMARY KEY,
+                name TEXT NOT NULL UNIQUE,
+                first_name TEXT,
+                last_name TEXT,
+                company TEXT,
+                position TEXT,
+                source TEXT
+            );
+            CREATE TABLE searches (
+                contact_id INTEGER NOT NULL REFERENCES contacts(id),
+                last_searched TEXT,
+                total_hits INTEGER NOT NULL,
+                error TEXT
+            );
+            CREATE TABLE hits (
+                contact_id INTEGER NOT NULL REFERENCES contacts(id),
+                rank INTEGER NOT NULL,
+                file_path TEXT,
+                pdf_url TEXT,
+                preview TEXT
+            );
+        """)
+
+        for sql, rows in (
+            ("INSERT INTO contacts VALUES (?, ?, ?, ?, ?, ?, ?)", contacts()),
+            ("INSERT INTO searches VALUES (?, ?, ?, ?)", searches()),
+            ("INSERT INTO hits VALUES (?, ?, ?, ?, ?)", hits()),
+        ):
+            for batch in _batched(rows, EXPORT_BATCH_SIZE):
+                conn.executemany(sql, batch)
+
+        # Build indexes after loading; it's much faster than maintaining them per insert
+        conn.executescript("""
+            CREATE INDEX contacts_company ON contacts(company);
+            CREATE UNIQUE INDEX searches_contact ON searches(contact_id);
+            CREATE INDEX searches_total_hits ON searches(total_hits);
+            CREATE INDEX hits_contact ON hits(contact_id, rank);
+            CREATE INDEX hits_file_path ON hits(file_path);
+        """)
+        conn.commit()
+    finally:
+        conn.close()
+
+
+def export_parquet(cache, output_dir):
+    """Export cached results as one Parquet file per normalized table."""
+    if not HAS_PYARROW:
+        print("Error: 'pyarrow' library is required for Parquet export. Install with: pip install pyarrow", file=sys.stderr)
+        sys.exit(1)
+
+    pa = pyarrow
+    contacts, searches, hits = _export_rows(cache)
+
+    tables = (
+        ('contacts', contacts(), pa.schema([
+            ('id', pa.int64()),
+            ('name', pa.string()),
+            ('first_name', pa.string()),
+            ('last_name', pa.string()),
+            ('company', pa.string()),
+            ('position', pa.string()),
+            ('source', pa.string()),
+        ])),
+        ('searches', searches(), pa.schema([
+            ('contact_id', pa.int64()),
+            ('last_searched', pa.timestamp('us')),
+            ('total_hits', pa.int64()),
+            ('error', pa.string()),
+        ])),
+        ('hits', hits(), pa.schema([
+            ('contact_id', pa.int64()),
+            ('rank', pa.int32()),
+            ('file_path', pa.string()),
+            ('pdf_url', pa.string()),
+            ('preview', pa.string()),
+        ])),
+    )
+
+    os.makedirs(output_dir, exist_ok=True)
+
+    for table_name, rows, schema in tables:
+        path = os.path.join(output_dir, f"{table_name}.parquet")
+        with pyarrow.parquet.ParquetWriter(path, schema) as writer:
+            # One row group per batch keeps memory bounded
+            for batch in _batched(rows, EXPORT_BATCH_SIZE):
+                columns = list(zip(*batch))
+                if table_name == 'searches':
+                    columns[1] = [datetime.fromisoformat(ts) if ts else None for ts in columns[1]]
+                writer.write_table(pa.Table.from_arrays(
+                    [pa.array(column, type=field.type) for column, field in zip(columns, schema)],
+                    schema=schema
+                ))
+
+
+def minify_css(css):
+    """Strip comments and insignificant whitespace from a stylesheet."""
+    css = re.sub(r'/\*.*?\*/', '', css, flags=re.S)
+    css = re.sub(r'\s+', ' ', css)
+    css = re.sub(r'\s*([{}:;,>])\s*', r'\1', css)
+    return css.replace(';}', '}').strip()
+
+
+# Minified once at import; every report embeds the same stylesheet.
+REPORT_CSS_MIN = minify_css(REPORT_CSS)
+
+
+@functools.lru_cache(maxsize=None)
+def _logo_data_uri(logo_path):
+    """Read and base64-encode the logo once per process."""
+    with open(logo_path, 'rb') as f:
+        return 'data:image/png;base64,' + base64.b64encode(f.read()).decode('utf-8')
+
+
+def render_logo(logo_mode, output_path):
+    """
+    Render the report header.
+    logo_mode is 'embed' (base64 data URI), 'external' (relative link to
+    assets/logo.png) or 'none' (text header only).
+    """
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    logo_path = os.path.join(script_dir, 'assets', 'logo.png')
+
+    if logo_mode != 'none' and os.path.exists(logo_path):
+        if logo_mode == 'external':
+            output_dir = os.path.dirname(os.path.abspath(output_path))
+            src = urllib.parse.quote(os.path.relpath(logo_path, output_dir).replace(os.sep, '/'))
+        else:
+            src = _logo_data_uri(logo_path)
+        return f'<img src="{src}" alt="EpsteOut" class="logo">'
+
+    return '<h1 class="logo" style="text-align: center;">EpsteOut</h1>'
+
+
+def render_sparkline(series, width=120, height=24):
+    """Render a mention-count series as a small inline SVG step chart."""
+    counts = [0] + [n for _, n in series]
+    peak = max(counts) or 1
+    step = width / (len(counts) - 1)
 
+    coords = [(i * step, height - 2 - (height - 4) * n / peak) for i, n in enumerate(counts)]
+    points = [f"{coords[0][0]:.1f},{coords[0][1]:.1f}"]
+    for (_, y0), (x1, y1) in zip(coords, coords[1:]):
+        # Step across at the old level, then to the new one
+        points.append(f"{x1:.1f},{y0:.1f}")
+        points.append(f"{x1:.1f},{y1:.1f}")
 
-def load_cache():
-    """Load cached search results from disk."""
-    if os.path.exists(CACHE_PATH):
-        with open(CACHE_PATH, 'r', encoding='utf-8') as f:
-            return json.load(f)
-    return {}
+    title = html.escape(', '.join(f"{t[:10]}: {n:,}" for t, n in series))
+    return (f'<svg class="sparkline" width="{width}" height="{height}" viewBox="0 0 {width} {height}">'
+            f'<title>{title}</title><polyline points="{" ".join(points)}"/></svg>')
 
 
-def save_cache(cache):
-    """Write cached search results to disk."""
-    with open(CACHE_PATH, 'w', encoding='utf-8') as f:
-        json.dump(cache, f, indent=2, ensure_ascii=False)
+def render_history(series):
+    """Render when a contact first appeared and how their count changed."""
+    first = next((t for t, n in series if n > 0), None)
+    if not first:
+        return ''
+    sparkline = render_sparkline(series) if len(series) > 1 else ''
+    return f'<div class="history">First seen {first[:10]} {sparkline}</div>'
 
 
-def get_api_key():
-    """Load API key from disk, or prompt the user for one."""
-    if os.path.exists(API_KEY_PATH):
-        with open(API_KEY_PATH, 'r') as f:
-            key = f.read().strip()
-            if key:
-                return key
+def render_contact_card(result):
+    """Render a contact with mentions as an HTML fragment."""
+    contact_info = []
+    if result['position']:
+        contact_info.append(html.escape(result['position']))
+    if result['company']:
+        contact_info.append(html.escape(result['company']))
+    info = ' at '.join(contact_info)
+    source = result.get('source', 'connections')
+    if source != 'connections':
+        via = f"from {html.escape(source.replace('_', ' '))}"
+        info = f"{info} ({via})" if info else via
 
-    print("An API key is required to search the Epstein files.")
-    print("To obtain one, visit: https://epstein.dugganusa.com/register.html")
-    print()
-    api_key = input("Enter your API key: ").strip()
+    parts = [f"""
+    <div class="contact">
+        <div class="contact-header">
+            <div>
+                <div class="contact-name">{html.escape(result['name'])}</div>
+                <div class="contact-info">{info}</div>
+                {render_history(result['history'])}
+            </div>
+            <div class="hit-count">{result['total_mentions']:,} mentions{f" ({result['unique_mentions']:,} unique)" if result['unique_mentions'] != result['total_mentions'] else ''}</div>
+        </div>
+"""]
 
-    if not api_key:
-        print("Error: No API key provided.", file=sys.stderr)
-        sys.exit(1)
+    if result['clusters']:
+        for cluster in result['clusters']:
+            parts.append(render_hit(cluster[0]))
 
-    with open(API_KEY_PATH, 'w') as f:
-        f.write(api_key)
+            if len(cluster) > 1:
+                parts.append(f"""
+        <details class="similar">
+            <summary>{len(cluster) - 1} similar document{'s' if len(cluster) > 2 else ''}</summary>
+""")
+                for hit in cluster[1:]:
+                    parts.append(render_hit(hit))
+                parts.append("""
+        </details>
+""")
+    else:
+        parts.append("""
+        <div class="no-results">Hit details not available</div>
+""")
 
-    print(f"API key saved to {API_KEY_PATH}\n")
-    return api_key
+    parts.append("""
+    </div>
+""")
+    return ''.join(parts)
 
 
-def parse_linkedin_contacts(csv_path):
-    """
-    Parse LinkedIn connections CSV export.
-    LinkedIn exports have columns: First Name, Last Name, Email Address, Company, Position, Connected On
-    """
-    contacts = []
+def _init_report_worker(hits_dict_path):
+    """Point a rendering process at the parent's hit dictionaries (which may be a corpus's)."""
+    global HITS_DICT_PATH
+    HITS_DICT_PATH = hits_dict_path
 
-    with open(csv_path, 'r', encoding='utf-8-sig') as f:
-        # Skip lines until we find the header row
-        # LinkedIn includes a "Notes" section at the top that must be skipped.
-        header_line = None
-        for line in f:
-            if 'First Name' in line and 'Last Name' in line:
-                header_line = line
-                break
 
-        if not header_line:
-            return contacts
+def _build_cards_chunk(chunk, dedup=True):
+    """
+    Cluster and render a chunk of (name, cache entry, history) contacts;
+    runs in a worker process. Returns the cards' HTML and the contacts'
+    results without their hits, which only the cards need.
+    """
+    cards = []
+    results = []
+    for name, entry, history in chunk:
+        result = build_result(name, entry, dedup, history)
+        cards.append(render_contact_card(result))
+        results.append({key: value for key, value in result.items() if key not in ('hits', 'clusters')})
+    return ''.join(cards), results
 
-        # Create a reader from the header line onwards
-        remaining_content = header_line + f.read()
-        reader = csv.DictReader(remaining_content.splitlines())
-
-        for row in reader:
-            first_name = row.get('First Name', '').strip()
-            last_name = row.get('Last Name', '').strip()
-
-            # Remove credentials/certifications (everything after the first comma)
-            if ',' in last_name:
-                last_name = last_name.split(',')[0].strip()
-
-            if first_name and last_name:
-                full_name = f"{first_name} {last_name}"
-                contacts.append({
-                    'first_name': first_name,
-                    'last_name': last_name,
-                    'full_name': full_name,
-                    'company': row.get('Company', ''),
-                    'position': row.get('Position', '')
-                })
 
-    return contacts
+def _entry_hit_bytes(entry):
+    """Roughly how much hit data a cache entry holds, without decompressing it."""
+    if 'hits_z' in entry:
+        return len(entry['hits_z'])
+    return len(json.dumps(entry.get('hits', [])))
 
 
-def search_epstein_files(name, delay, api_key):
+class ReportWriter:
     """
-    Search the Epstein files API for a name.
-    Returns (result_dict, delay) where delay may be increased on 429 responses.
+    Write report text to a plain file, a gzip-compressed copy, or both.
+    compress is 'none', 'gzip' (only <output>.gz) or 'both'.
     """
-    # Wrap name in quotes for exact phrase matching
-    quoted_name = f'"{name}"'
-    encoded_name = urllib.parse.quote(quoted_name)
-    url = f"{API_BASE_URL}?q={encoded_name}&indexes=epstein_files"
-    headers = {"Authorization": f"Bearer {api_key}"}
 
-    while True:
-        try:
-            response = requests.get(url, headers=headers, timeout=30)
+    def __init__(self, output_path, compress='none'):
+        self.paths = []
+        self.files = []
 
-            if response.status_code == 429:
-                retry_after = response.headers.get('Retry-After')
+        if compress in ('none', 'both'):
+            self.paths.append(output_path)
+            self.files.append(open(output_path, 'w', encoding='utf-8'))
 
-                if retry_after:
-                    delay = int(retry_after)
-                else:
-                    delay *= 2
+        if compress in ('gzip', 'both'):
+            gz_path = output_path if output_path.endswith('.gz') else output_path + '.gz'
+            self.paths.append(gz_path)
+            self.files.append(gzip.open(gz_path, 'wt', encoding='utf-8', compresslevel=9))
 
-                print(f" [429 rate limited, retrying in {delay}s]", end='', flush=True)
-                time.sleep(delay)
-                continue
+    def write(self, text):
+        for f in self.files:
+            f.write(text)
 
-            response.raise_for_status()
-            data = response.json()
-
-            if data.get('success'):
-                return {
-                    'total_hits': data.get('data', {}).get('totalHits', 0),
-                    'hits': data.get('data', {}).get('hits', [])
-                }, delay
-        except requests.exceptions.ConnectTimeout:
-            delay *= 2
-            print(f" [connect timeout, retrying in {delay}s]", end='', flush=True)
-            time.sleep(delay)
-            continue
-        except requests.exceptions.RequestException as e:
-            print(f"Warning: API request failed for '{name}': {e}", file=sys.stderr)
-            return {'total_hits': 0, 'hits': [], 'error': str(e)}, delay
+    def close(self):
+        for f in self.files:
+            f.close()
 
-        return {'total_hits': 0, 'hits': []}, delay
+    def __enter__(self):
+        return self
 
+    def __exit__(self, *exc):
+        self.close()
 
-def generate_html_report(results, output_path):
-    contacts_with_mentions = len([r for r in results if r['total_mentions'] > 0])
 
-    # Read and encode logo as base64 data URI, or fall back to text header
-    script_dir = os.path.dirname(os.path.abspath(__file__))
-    logo_path = os.path.join(script_dir, 'assets', 'logo.png')
-    if os.path.exists(logo_path):
-        with open(logo_path, 'rb') as f:
-            logo_base64 = base64.b64encode(f.read()).decode('utf-8')
-        logo_html = f'<img src="data:image/png;base64,{logo_base64}" alt="EpsteOut" class="logo">'
+def render_watchlist_changes(watch_changes):
+    """Render the watchlist change box shown above the contact cards."""
+    if not watch_changes:
+        return ''
+
+    items = ''.join(
+        f"<li><strong>{html.escape(name)}</strong>: {previous or 0:,} &rarr; {total:,} mentions</li>"
+        for name, previous, total in watch_changes
+    )
+    return f"""
+    <div class="watchlist">
+        <strong>Watchlist changes this run</strong>
+        <ul>{items}</ul>
+    </div>
+"""
+
+
+def generate_html_report(contacts, output_path, compress='none', logo_mode='embed', render_workers=0,
+                         watch_changes=(), dedup=True):
+    """
+    Write the HTML report for contacts, (name, cache entry, history)
+    tuples in report order. Returns (files written, results), where the
+    results of contacts with mentions don't carry their hits.
+    watch_changes, (name, previous total, new total) tuples, are listed
+    at the top.
+    render_workers is the number of processes clustering and rendering
+    cards; 0 picks one per CPU for large reports and works in-process
+    otherwise.
+    """
+    cards = [contact for contact in contacts if contact[1]['total_hits'] > 0]
+
+    if render_workers == 0:
+        hit_bytes = sum(_entry_hit_bytes(entry) for _, entry, _ in cards)
+        render_workers = (os.cpu_count() or 1) if hit_bytes >= PARALLEL_RENDER_MIN_BYTES else 1
+
+    # The summary above the cards needs every card's near-duplicate count,
+    # so the cards are built before anything is written.
+    build_chunk = functools.partial(_build_cards_chunk, dedup=dedup)
+    if render_workers > 1:
+        with concurrent.futures.ProcessPoolExecutor(max_workers=render_workers, initializer=_init_report_worker,
+                                                    initargs=(HITS_DICT_PATH,)) as pool:
+            built = list(pool.map(build_chunk, _batched(cards, RENDER_CHUNK_SIZE)))
     else:
-        logo_html = '<h1 class="logo" style="text-align: center;">EpsteOut</h1>'
+        built = [build_chunk(chunk) for chunk in _batched(cards, RENDER_CHUNK_SIZE)]
 
-    html_content = f"""<!DOCTYPE html>
+    card_results = iter([result for _, chunk_results in built for result in chunk_results])
+    results = [
+        next(card_results) if entry['total_hits'] > 0 else build_result(name, entry, dedup, history)
+        for name, entry, history in contacts
+    ]
+    contacts_with_mentions = len(cards)
+
+    with ReportWriter(output_path, compress) as out:
+        out.write(f"""<!DOCTYPE html>
 <html lang="en">
 <head>
     <meta charset="UTF-8">
     <meta name="viewport" content="width=device-width, initial-scale=1.0">
     <title>EpsteOut: Which LinkedIn Connections Appear in the Epstein Files?</title>
-    <style>
-        * {{
-            box-sizing: border-box;
-        }}
-        body {{
-            font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Roboto, Oxygen, Ubuntu, sans-serif;
-            line-height: 1.6;
-            max-width: 1200px;
-            margin: 0 auto;
-            padding: 20px;
-            background-color: #f5f5f5;
-        }}
-        .logo {{
-            display: block;
-            max-width: 300px;
-            margin: 0 auto 20px auto;
-        }}
-        .summary {{
-            background: #fff;
-            padding: 20px;
-            border-radius: 8px;
-            margin-bottom: 30px;
-            box-shadow: 0 2px 4px rgba(0,0,0,0.1);
-        }}
-        .contact {{
-            background: #fff;
-            padding: 20px;
-            margin-bottom: 20px;
-            border-radius: 8px;
-            box-shadow: 0 2px 4px rgba(0,0,0,0.1);
-        }}
-        .contact-header {{
-            display: flex;
-            justify-content: space-between;
-            align-items: center;
-            border-bottom: 1px solid #eee;
-            padding-bottom: 10px;
-            margin-bottom: 15px;
-        }}
-        .contact-name {{
-            font-size: 1.4em;
-            font-weight: bold;
-            color: #333;
-        }}
-        .contact-info {{
-            color: #666;
-            font-size: 0.9em;
-        }}
-        .hit-count {{
-            background: #e74c3c;
-            color: white;
-            padding: 5px 15px;
-            border-radius: 20px;
-            font-weight: bold;
-        }}
-        .hit {{
-            background: #f9f9f9;
-            padding: 15px;
-            margin-bottom: 10px;
-            border-radius: 4px;
-            border-left: 3px solid #3498db;
-        }}
-        .hit-preview {{
-            color: #444;
-            margin-bottom: 10px;
-            font-size: 0.95em;
-        }}
-        .hit-link {{
-            display: inline-block;
-            color: #3498db;
-            text-decoration: none;
-            font-size: 0.85em;
-        }}
-        .hit-link:hover {{
-            text-decoration: underline;
-        }}
-        .no-results {{
-            color: #999;
-            font-style: italic;
-        }}
-        .footer {{
-            margin-top: 40px;
-            padding-top: 20px;
-            border-top: 1px solid #ddd;
-            text-align: center;
-            color: #666;
-            font-size: 0.9em;
-        }}
-        .footer a {{
-            color: #3498db;
-            text-decoration: none;
-        }}
-        .footer a:hover {{
-            text-decoration: underline;
-        }}
-    </style>
+    <style>{REPORT_CSS_MIN}</style>
 </head>
 <body>
-    {logo_html}
+    {render_logo(logo_mode, output_path)}
 
     <div class="summary">
         <strong>Total connections searched:</strong> {len(results)}<br>
-        <strong>Connections with mentions:</strong> {contacts_with_mentions}
+        <strong>Connections with mentions:</strong> {contacts_with_mentions}<br>
+        <strong>Total mentions:</strong> {sum(r['total_mentions'] for r in results):,} ({sum(r['unique_mentions'] for r in results):,} after collapsing near-duplicates)
     </div>
-"""
+{render_watchlist_changes(watch_changes)}""")
 
-    for result in results:
-        if result['total_mentions'] == 0:
-            continue
+        for fragment, _ in built:
+            out.write(fragment)
 
-        contact_info = []
-        if result['position']:
-            contact_info.append(html.escape(result['position']))
-        if result['company']:
-            contact_info.append(html.escape(result['company']))
+        out.write("""
+    <div class="footer">
+        Epstein files indexed by <a href="https://dugganusa.com" target="_blank">DugganUSA.com</a>
+    </div>
+</body>
+</html>
+""")
 
-        html_content += f"""
-    <div class="contact">
-        <div class="contact-header">
-            <div>
-                <div class="contact-name">{html.escape(result['name'])}</div>
-                <div class="contact-info">{' at '.join(contact_info) if contact_info else ''}</div>
-            </div>
-            <div class="hit-count">{result['total_mentions']:,} mentions</div>
-        </div>
-"""
+    return out.paths, results
 
-        if result['hits']:
-            for hit in result['hits']:
-                preview = hit.get('content_preview') or (hit.get('content') or '')[:500]
 
-                pdf_url = hit.get('doj_url', '')
+class ReportSnapshot:
+    """
+    One loaded version of the cache and mention history for --serve, with
+    the rows pre-sorted for every sort order. It isn't changed after it's
+    built (apart from filling the clustered results cache), so requests
+    share it without locking.
+    """
 
-                if not pdf_url:
-                    file_path = hit.get('file_path', '')
-                    if file_path:
-                        file_path = file_path.replace('dataset', 'DataSet')
-                        base_url = PDF_BASE_URL.rstrip('/') if file_path.startswith('/') else PDF_BASE_URL
-                        pdf_url = base_url + urllib.parse.quote(file_path, safe='/')
-                    else:
-                        pdf_url = ''
+    def __init__(self, version, cache_path, history_path):
+        self.version = version
+        self.cache = load_cache(cache_path)
+        self.history = HistoryStore(history_path).series()
+        self.rows = [{
+            'name': name,
+            'company': entry.get('company') or '',
+            'position': entry.get('position') or '',
+            'source': entry.get('source', 'connections'),
+            'total_mentions': entry.get('total_hits', 0),
+            'last_searched': entry.get('last_searched') or '',
+        } for name, entry in self.cache.items()]
+        self.orders = {sort: sorted(self.rows, key=key) for sort, (key, _) in ReportServer.SORTS.items()}
+        self.mention_counts = sorted(row['total_mentions'] for row in self.rows)
+        self.built = {}
 
-                html_content += f"""
-        <div class="hit">
-            <div class="hit-preview">{html.escape(preview)}</div>
-            {f'<a class="hit-link" href="{html.escape(pdf_url)}" target="_blank">View PDF: {html.escape(pdf_url)}</a>' if pdf_url else ''}
-        </div>
-"""
-        else:
-            html_content += """
-        <div class="no-results">Hit details not available</div>
-"""
 
-        html_content += """
-    </div>
-"""
+class ReportServer:
+    """
+    Query and render the cache for --serve. The cache and mention history
+    are reloaded into a new ReportSnapshot when their files change; only
+    the requested page of contacts is clustered and rendered, outside the
+    lock, so concurrent requests don't wait on each other. Rendered
+    responses are kept in an LRU cache that is cleared on reload.
+    """
 
-    html_content += """
-    <div class="footer">
-        Epstein files indexed by <a href="https://dugganusa.com" target="_blank">DugganUSA.com</a>
-    </div>
+    # Sort keys, and whether each sorts descending by default
+    SORTS = {
+        'mentions': (lambda row: (row['total_mentions'], row['name']), True),
+        'name': (lambda row: row['name'].lower(), False),
+        'company': (lambda row: (row['company'].lower(), row['name'].lower()), False),
+        'searched': (lambda row: row['last_searched'], True),
+    }
+
+    def __init__(self, cache_path=None, history_path=None, dedup=True, logo_mode='embed'):
+        self.cache_path = cache_path or CACHE_PATH
+        self.history_path = history_path or HISTORY_PATH
+        self.dedup = dedup
+        # Pages are served from /, so an external logo is linked as assets/logo.png
+        script_dir = os.path.dirname(os.path.abspath(__file__))
+        self.logo = render_logo(logo_mode, os.path.join(script_dir, 'index.html'))
+        self.logo_path = os.path.join(script_dir, 'assets', 'logo.png') if logo_mode == 'external' else None
+        self.lock = threading.Lock()
+        self.snapshot = None
+        self.responses = {}
+
+    def _file_version(self):
+        version = []
+        for path in (self.cache_path, self.history_path):
+            try:
+                stat = os.stat(path)
+                version.append((stat.st_mtime_ns, stat.st_size))
+            except OSError:
+                version.append(None)
+        return tuple(version)
+
+    def current_snapshot(self):
+        """The snapshot of the current cache and history files, reloading them if either changed."""
+        version = self._file_version()
+        with self.lock:
+            if self.snapshot is None or self.snapshot.version != version:
+                self.snapshot = ReportSnapshot(version, self.cache_path, self.history_path)
+                self.responses.clear()
+            return self.snapshot
+
+    def query(self, snapshot, params):
+        """
+        Filter, sort and page a snapshot. params are the request's query
+        string values: q (name or company substring), min (minimum
+        mentions, default 1), sort, order (asc or desc), page and per_page.
+        Returns (matching count, page number, page size, rows on the page).
+        Without a q filter, the count comes from a bisection and only the
+        rows up to the requested page are visited.
+        """
+        text = params.get('q', '').strip().lower()
+        min_mentions = int(params.get('min', 1))
+        sort = params.get('sort') if params.get('sort') in self.SORTS else 'mentions'
+        descending = self.SORTS[sort][1]
+        if params.get('order') in ('asc', 'desc'):
+            descending = params['order'] == 'desc'
+        per_page = max(1, min(int(params.get('per_page', SERVE_PAGE_SIZE)), SERVE_MAX_PAGE_SIZE))
+        page = max(1, int(params.get('page', 1)))
+        start = (page - 1) * per_page
+
+        ordered = snapshot.orders[sort]
+        rows = (row for row in (reversed(ordered) if descending else ordered)
+                if row['total_mentions'] >= min_mentions)
+        if text:
+            rows = [row for row in rows if text in row['name'].lower() or text in row['company'].lower()]
+            return len(rows), page, per_page, rows[start:start + per_page]
+
+        total = len(snapshot.mention_counts) - bisect.bisect_left(snapshot.mention_counts, min_mentions)
+        return total, page, per_page, list(itertools.islice(rows, start, start + per_page))
+
+    def results(self, snapshot, rows):
+        """Clustered results for rows, reusing ones built for earlier pages."""
+        results = []
+        for row in rows:
+            name = row['name']
+            result = snapshot.built.get(name)
+            if result is None:
+                if len(snapshot.built) >= SERVE_RESULT_CACHE_SIZE:
+                    snapshot.built.clear()
+                result = build_result(name, snapshot.cache[name], self.dedup, snapshot.history.get(name))
+                snapshot.built[name] = result
+            results.append(result)
+        return results
+
+    def render_json(self, snapshot, params):
+        total, page, per_page, rows = self.query(snapshot, params)
+        results = []
+        for row, result in zip(rows, self.results(snapshot, rows)):
+            results.append({
+                'name': result['name'],
+                'company': result['company'],
+                'position': result['position'],
+                'source': result['source'],
+                'total_mentions': result['total_mentions'],
+                'unique_mentions': result['unique_mentions'],
+                'last_searched': row['last_searched'],
+                'hits': result['hits'],
+            })
+        return json.dumps({'total': total, 'page': page, 'per_page': per_page, 'results': results})
+
+    def render_page(self, snapshot, params):
+        total, page, per_page, rows = self.query(snapshot, params)
+        pages = max(1, -(-total // per_page))
+
+        def link(label, page_number):
+            query = urllib.parse.urlencode({**params, 'page': page_number})
+            return f'<a href="?{html.escape(query)}">{label}</a>'
+
+        def option(value, label, current):
+            selected = ' selected' if value == current else ''
+            return f'<option value="{value}"{selected}>{label}</option>'
+
+        sort = params.get('sort', 'mentions')
+        pager = ' '.join(filter(None, [
+            link('&larr; Previous', page - 1) if page > 1 else '',
+            f'Page {page:,} of {pages:,}',
+            link('Next &rarr;', page + 1) if page < pages else '',
+        ]))
+        cards = ''.join(render_contact_card(result) for result in self.results(snapshot, rows))
+
+        return f"""<!DOCTYPE html>
+<html lang="en">
+<head>
+    <meta charset="UTF-8">
+    <meta name="viewport" content="width=device-width, initial-scale=1.0">
+    <title>EpsteOut: Which LinkedIn Connections Appear in the Epstein Files?</title>
+    <style>{REPORT_CSS_MIN}</style>
+</head>
+<body>
+    {self.logo}
+
+    <form class="summary" method="get">
+        <input type="search" name="q" value="{html.escape(params.get('q', ''))}" placeholder="Name or company">
+        Min. mentions <input type="number" name="min" min="0" value="{html.escape(params.get('min', '1'))}" style="width: 5em">
+        <select name="sort">
+            {option('mentions', 'Most mentions', sort)}
+            {option('name', 'Name', sort)}
+            {option('company', 'Company', sort)}
+            {option('searched', 'Recently searched', sort)}
+        </select>
+        <button type="submit">Filter</button>
+        <div>{total:,} of {len(snapshot.rows):,} contacts &middot; {pager}</div>
+    </form>
+{cards}
+    <div class="footer">{pager}</div>
 </body>
 </html>
 """
 
-    with open(output_path, 'w', encoding='utf-8') as f:
-        f.write(html_content)
+    def respond(self, path, params):
+        """Return (status, content type, body bytes) for a GET request."""
+        if path == '/assets/logo.png' and self.logo_path:
+            with open(self.logo_path, 'rb') as f:
+                return 200, 'image/png', f.read()
 
+        routes = {
+            '/': (self.render_page, 'text/html; charset=utf-8'),
+            '/api/contacts': (self.render_json, 'application/json'),
+        }
+        if path not in routes:
+            return 404, 'text/plain; charset=utf-8', b'Not found'
+        render, content_type = routes[path]
+
+        snapshot = self.current_snapshot()
+        key = (path, tuple(sorted(params.items())))
+        with self.lock:
+            body = self.responses.pop(key, None)
+            if body is not None:
+                # Reinserting keeps the dict in least- to most-recently-used order
+                self.responses[key] = body
+                return 200, content_type, body
+
+        try:
+            body = render(snapshot, params).encode('utf-8')
+        except ValueError:
+            return 400, 'text/plain; charset=utf-8', b'Invalid query parameter'
+
+        with self.lock:
+            # A reload while rendering cleared the cache; don't refill it with a stale page
+            if snapshot is self.snapshot:
+                if len(self.responses) >= SERVE_RESPONSE_CACHE_SIZE:
+                    del self.responses[next(iter(self.responses))]
+                self.responses[key] = body
+        return 200, content_type, body
 
-def main():
-    if not HAS_REQUESTS:
-        print("Error: 'requests' library is required. Install with: pip install requests", file=sys.stderr)
-        sys.exit(1)
 
+def serve_report(port, dedup=True, logo_mode='embed'):
+    """Serve the cache as a browsable report on localhost until interrupted."""
+    report = ReportServer(dedup=dedup, logo_mode=logo_mode)
+
+    class Handler(http.server.BaseHTTPRequestHandler):
+        def do_GET(self):
+            url = urllib.parse.urlsplit(self.path)
+            params = dict(urllib.parse.parse_qsl(url.query))
+            status, content_type, body = report.respond(url.path, params)
+            self.send_response(status)
+            self.send_header('Content-Type', content_type)
+            self.send_header('Content-Length', str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, format, *args):
+            pass
+
+    server = http.server.ThreadingHTTPServer(('127.0.0.1', port), Handler)
+    print(f"Serving the report at http://127.0.0.1:{port}/ (JSON at /api/contacts); press Ctrl+C to stop")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+
+def main():
     parser = argparse.ArgumentParser(
         description='Search Epstein files for mentions of LinkedIn connections'
     )
@@ -367,10 +3630,243 @@ def main():
         default='EpsteOut.html',
         help='Output HTML file for the report (default: EpsteOut.html)'
     )
+    parser.add_argument(
+        '--compress',
+        choices=['none', 'gzip', 'both'],
+        default='none',
+        help='Write the report as plain HTML, as <output>.gz, or both (default: none)'
+    )
+    parser.add_argument(
+        '--logo',
+        choices=['embed', 'external', 'none'],
+        default='embed',
+        help='Embed the logo, link to assets/logo.png, or omit it (default: embed)'
+    )
+    parser.add_argument(
+        '--render-workers',
+        type=int,
+        default=0,
+        help='Processes used to cluster and render report cards (default: one per CPU for large reports)'
+    )
+    parser.add_argument(
+        '--archive',
+        help='Path to the full LinkedIn data archive (ZIP or extracted folder); also searches people from '
+             'messages, invitations, imported contacts and endorsements'
+    )
+    parser.add_argument(
+        '--parse-workers',
+        type=int,
+        default=0,
+        help='Processes used to parse the connections CSV (default: one per CPU for files of 32 MB or more)'
+    )
+    parser.add_argument(
+        '--corpus',
+        metavar='PATH',
+        help='Search a local corpus file (built with --build-corpus) instead of the API'
+    )
+    parser.add_argument(
+        '--build-corpus',
+        metavar='DIR',
+        help='Pack the .txt files under DIR into the --corpus file, then exit'
+    )
+    parser.add_argument(
+        '--corpus-index',
+        action='store_true',
+        help='Search the --corpus through a suffix-array index (built on first use) for fast substring lookups'
+    )
+    parser.add_argument(
+        '--match-all',
+        action='store_true',
+        help='Match every connection against the --corpus in one vectorized pass over its tokens'
+    )
+    parser.add_argument(
+        '--benchmark-index',
+        action='store_true',
+        help='Report suffix index size, build time and query latency for --corpus (names from --connections), then exit'
+    )
+    parser.add_argument(
+        '--rebuild-index',
+        action='store_true',
+        help='With --benchmark-index, rebuild the suffix index to time the build'
+    )
+    parser.add_argument(
+        '--train-dictionary',
+        action='store_true',
+        help='Retrain the compression dictionary for cached hits and recompress the cache'
+    )
+    parser.add_argument(
+        '--annotate',
+        metavar='PATH',
+        help='Write a copy of --connections with mention count, top document and search date columns added'
+    )
+    parser.add_argument(
+        '--serve',
+        type=int,
+        nargs='?',
+        const=8080,
+        metavar='PORT',
+        help='Browse the cached results in a local web server instead of writing a report (default port: 8080)'
+    )
+    parser.add_argument(
+        '--history',
+        metavar='NAME',
+        help='Show when a contact first appeared and how their mentions changed, then exit'
+    )
+    parser.add_argument(
+        '--export',
+        metavar='PATH',
+        help='Export cached results for analytics instead of searching, then exit'
+    )
+    parser.add_argument(
+        '--export-format',
+        choices=['sqlite', 'parquet'],
+        help='Export format (default: parquet if PATH ends in .parquet, otherwise sqlite)'
+    )
+    parser.add_argument(
+        '--force',
+        action='store_true',
+        help='Let --export overwrite an existing file that is not a previous export'
+    )
+    parser.add_argument(
+        '--resume',
+        action='store_true',
+        help='Continue an interrupted run exactly where it stopped'
+    )
+    parser.add_argument(
+        '--daily-quota',
+        type=int,
+        metavar='N',
+        help='Spread refreshes across days so no day uses more than N searches'
+    )
+    parser.add_argument(
+        '--watchlist',
+        metavar='FILE',
+        help='File of names or LinkedIn profile URLs (one per line) to refresh more often and ahead of other contacts'
+    )
+    parser.add_argument(
+        '--watchlist-ttl-hours',
+        type=float,
+        default=1.0,
+        help='How often watchlist contacts are refreshed, in hours (default: 1)'
+    )
+    parser.add_argument(
+        '--workers',
+        type=int,
+        default=1,
+        help='Number of searches to run concurrently (default: 1)'
+    )
+    parser.add_argument(
+        '--queue',
+        metavar='PATH',
+        help='Share the planned searches through a SQLite job queue at PATH; run more processes with the same '
+             '--queue to add workers'
+    )
+    parser.add_argument(
+        '--shared-rate-limit',
+        type=float,
+        metavar='RPS',
+        help='Cap requests per second across all EpsteOut processes on this host using the same API key'
+    )
+    parser.add_argument(
+        '--shutdown-timeout',
+        type=float,
+        default=10.0,
+        help='Seconds to let in-flight searches finish after Ctrl+C (default: 10)'
+    )
+    parser.add_argument(
+        '--log-json',
+        metavar='PATH',
+        help='Append one JSON record per API request attempt to PATH'
+    )
+    parser.add_argument(
+        '--trace',
+        metavar='PATH',
+        help='Write a Chrome trace-event JSON file of the run (open in Perfetto or chrome://tracing)'
+    )
+    parser.add_argument(
+        '--trace-sample',
+        type=float,
+        default=1.0,
+        help='Fraction of searches to include in the trace (default: 1.0)'
+    )
+    parser.add_argument(
+        '--api-url',
+        default=API_BASE_URL,
+        help='Search API endpoint, e.g. a local mock (default: %(default)s)'
+    )
+    parser.add_argument(
+        '--no-dedup',
+        action='store_true',
+        help='Show every hit instead of collapsing near-duplicate documents'
+    )
     args = parser.parse_args()
 
+    if args.corpus and not (args.build_corpus or args.benchmark_index):
+        use_corpus_state(args.corpus)
+
+    if args.build_corpus:
+        if not args.corpus:
+            print("Error: --build-corpus requires --corpus PATH for the output file.", file=sys.stderr)
+            sys.exit(1)
+        count = build_corpus(args.build_corpus, args.corpus)
+        print(f"Packed {count:,} documents from {args.build_corpus} into {args.corpus}")
+        sys.exit(0)
+
+    if args.benchmark_index:
+        if not args.corpus:
+            print("Error: --benchmark-index requires --corpus PATH.", file=sys.stderr)
+            sys.exit(1)
+        corpus = CorpusStore(args.corpus)
+        build_seconds = None
+        if args.rebuild_index or not os.path.exists(args.corpus + '.sa'):
+            started = time.perf_counter()
+            build_suffix_index(corpus, args.corpus + '.sa')
+            build_seconds = time.perf_counter() - started
+        if args.connections:
+            names = [c['full_name'] for c in parse_linkedin_contacts(args.connections, args.parse_workers)]
+        else:
+            names = ["O'Brien", "Smith-Jones", "flight manifest", "island"]
+        benchmark_suffix_index(corpus, names, build_seconds)
+        sys.exit(0)
+
+    if args.serve is not None:
+        serve_report(args.serve, dedup=not args.no_dedup, logo_mode=args.logo)
+        sys.exit(0)
+
+    if args.history:
+        print_history(HistoryStore(), args.history)
+        sys.exit(0)
+
+    if args.train_dictionary:
+        size_before = os.path.getsize(CACHE_PATH) if os.path.exists(CACHE_PATH) else 0
+        codec, _ = train_shared_hit_dictionary(force=True)
+        if codec is None:
+            print("No cached hits to train a dictionary on.")
+        else:
+            print(f"Trained a {len(codec.dictionary) // 1024} KB {codec.kind} dictionary ({codec.id}); "
+                  f"cache {size_before / 1e6:.1f} MB -> {os.path.getsize(CACHE_PATH) / 1e6:.1f} MB")
+        sys.exit(0)
+
+    if args.export:
+        export_format = args.export_format or ('parquet' if args.export.endswith('.parquet') else 'sqlite')
+        cache = load_cache()
+        print(f"Exporting {len(cache)} cached contacts to: {args.export} ({export_format})")
+        if export_format == 'parquet':
+            export_parquet(cache, args.export)
+        else:
+            export_sqlite(cache, args.export, force=args.force)
+        sys.exit(0)
+
+    if args.annotate:
+        if not args.connections or not os.path.exists(args.connections):
+            print("Error: --annotate requires an existing --connections file", file=sys.stderr)
+            sys.exit(1)
+        rows, annotated = annotate_connections(args.connections, load_cache(), args.annotate)
+        print(f"Annotated {annotated:,} of {rows:,} connections: {args.annotate}")
+        sys.exit(0)
+
     # Validate inputs
-    if not args.connections:
+    if not args.connections and not args.archive and not (args.resume and os.path.exists(CHECKPOINT_PATH)):
         print("""
 No connections file specified.
 
@@ -390,82 +3886,200 @@ To export your LinkedIn connections:
 """)
         sys.exit(1)
 
-    if not os.path.exists(args.connections):
-        print(f"Error: Connections file not found: {args.connections}", file=sys.stderr)
+    if args.match_all and not args.corpus:
+        print("Error: --match-all requires --corpus", file=sys.stderr)
         sys.exit(1)
 
-    # Parse LinkedIn connections
-    print(f"Reading LinkedIn connections from: {args.connections}")
-    contacts = parse_linkedin_contacts(args.connections)
-    print(f"Found {len(contacts)} connections")
+    tracer = Tracer(args.trace, args.trace_sample) if args.trace else NULL_TRACER
 
-    if not contacts:
-        print("No connections found in CSV. Check the file format.", file=sys.stderr)
-        sys.exit(1)
+    # Load cached results from previous runs
+    with tracer.span('load_cache') as span_args:
+        cache = load_cache()
+        span_args['entries'] = len(cache)
 
-    # Get API key (prompts user if not stored)
-    api_key = get_api_key()
+    checkpoint = load_checkpoint() if args.resume else None
+    watchlist = load_watchlist(args.watchlist) if args.watchlist else (set(), set())
 
-    # Load cached results from previous runs
-    cache = load_cache()
+    if checkpoint:
+        # Resume the interrupted run's plan exactly; no CSV parse or rescan
+        contacts = checkpoint['contacts']
+        planned = checkpoint['queue']
+        progress = checkpoint
+        remaining = len(planned) - progress['cursor'] - len(progress['done_ahead'])
+        print(f"Resuming run from {checkpoint['created']}: {remaining} of {len(planned)} searches remaining")
+        watched = watched_contacts(contacts, watchlist)
+    else:
+        if args.resume:
+            print("No checkpoint to resume; starting a new run.")
 
-    # Sort contacts: never-searched first, then oldest-searched first
-    def sort_key(contact):
-        cached = cache.get(contact['full_name'])
-        if cached is None:
-            return (0, '')  # Never searched — highest priority
-        return (1, cached.get('last_searched', ''))
+        for path, label in ((args.connections, 'Connections file'), (args.archive, 'Archive')):
+            if path and not os.path.exists(path):
+                print(f"Error: {label} not found: {path}", file=sys.stderr)
+                sys.exit(1)
 
-    contacts.sort(key=sort_key)
+        # Parse LinkedIn connections
+        print(f"Reading LinkedIn connections from: {args.connections or args.archive}")
+        with tracer.span('parse_csv') as span_args:
+            if args.connections:
+                contacts = parse_linkedin_contacts(args.connections, args.parse_workers)
+            else:
+                contacts = parse_archive_connections(args.archive, args.parse_workers)
+            span_args['contacts'] = len(contacts)
+        print(f"Found {len(contacts)} connections")
 
-    # Search for each contact
-    print("Searching Epstein files API...")
-    print("(Press Ctrl+C to stop and generate a partial report)\n")
-    searched_this_run = set()
+        if args.archive:
+            # Add everyone else the archive names who isn't already a connection
+            with tracer.span('parse_archive') as span_args:
+                others, counts = parse_archive_contacts(args.archive, contacts)
+                span_args['contacts'] = len(others)
+            contacts.extend(others)
+            if counts:
+                print(f"Found {len(others)} more people in the archive: "
+                      + ", ".join(f"{count} from {source.replace('_', ' ')}" for source, count in counts.items()))
 
-    delay = 0.25
+        if not contacts:
+            print("No connections found in CSV. Check the file format.", file=sys.stderr)
+            sys.exit(1)
 
-    try:
-        for i, contact in enumerate(contacts):
-            print(f"  [{i+1}/{len(contacts)}] {contact['full_name']}", end='', flush=True)
-
-            # Skip contacts searched in the last 23 hours
-            cached_entry = cache.get(contact['full_name'])
-            if cached_entry and 'last_searched' in cached_entry:
-                age = datetime.now() - datetime.fromisoformat(cached_entry['last_searched'])
-                if age.total_seconds() < 23 * 3600:
-                    print(f" -> skipped (cached {age.total_seconds() / 3600:.1f}h ago)")
+        # Sort contacts: never-searched first, then oldest-searched first
+        def sort_key(contact):
+            cached = cache.get(contact['full_name'])
+            if cached is None:
+                return (0, '')  # Never searched — highest priority
+            return (1, cached.get('last_searched', ''))
+
+        contacts.sort(key=sort_key)
+
+        # Watchlist contacts are searched in their own priority lane, not the bulk plan
+        watched = watched_contacts(contacts, watchlist)
+        if args.watchlist:
+            print(f"{len(watched)} connections on the watchlist (refreshed every {args.watchlist_ttl_hours:g}h)")
+
+        if args.daily_quota:
+            # Plan the run: only today's slice of the multi-day schedule,
+            # leaving room for the watchlist lane's refreshes
+            reserved = watch_lane_searches_per_day(watched, args.watchlist_ttl_hours)
+            if reserved >= args.daily_quota:
+                print(f"Error: the watchlist needs {reserved:,} searches a day, more than the daily quota of "
+                      f"{args.daily_quota:,}; raise --watchlist-ttl-hours or shorten the watchlist", file=sys.stderr)
+                sys.exit(1)
+            due_now = watched_due_now(contacts, cache, watched, args.watchlist_ttl_hours)
+            planned, schedule = plan_refresh_schedule(contacts, cache, args.daily_quota, skip=watched,
+                                                      reserved=reserved, reserved_now=due_now)
+            save_schedule(schedule)
+            print(f"{len(planned)} connections scheduled for today under a daily quota of {args.daily_quota:,}"
+                  + (f" ({reserved:,} a day reserved for the watchlist)" if reserved else ""))
+            print_quota_projection(schedule)
+        else:
+            # Plan the run: only contacts not searched in the last 23 hours
+            now = datetime.now()
+            planned = []
+            for i, contact in enumerate(contacts):
+                if i in watched:
                     continue
+                cached_entry = cache.get(contact['full_name'])
+                if cached_entry and 'last_searched' in cached_entry:
+                    age = now - datetime.fromisoformat(cached_entry['last_searched'])
+                    if age.total_seconds() < CACHE_TTL_HOURS * 3600:
+                        continue
+                planned.append(i)
 
-            search_result, delay = search_epstein_files(contact['full_name'], delay, api_key)
-            total_mentions = search_result['total_hits']
-
-            print(f" -> {total_mentions} hits")
-
-            # Update cache immediately so interrupted runs keep progress
-            cache[contact['full_name']] = {
-                'last_searched': datetime.now().isoformat(),
-                'total_hits': total_mentions,
-                'hits': search_result['hits'],
-                'first_name': contact['first_name'],
-                'last_name': contact['last_name'],
-                'company': contact['company'],
-                'position': contact['position'],
-            }
-            save_cache(cache)
-            searched_this_run.add(contact['full_name'])
+            fresh = len(contacts) - len(planned) - len(watched)
+            print(f"{len(planned)} connections due for a search, {fresh} cached in the last {CACHE_TTL_HOURS} hours")
 
-            # Rate limiting
-            if i < len(contacts) - 1:
-                time.sleep(delay)
+        progress = {'cursor': 0, 'delay': 0.25, 'done_ahead': []}
+        if not args.queue:
+            save_checkpoint(contacts, planned)
 
-    except KeyboardInterrupt:
-        print("\n\nSearch interrupted by user (Ctrl+C).")
+    if args.corpus:
+        # Search the local corpus instead of the API
+        corpus = CorpusStore(args.corpus)
+        if args.match_all:
+            started = time.perf_counter()
+            store = TokenStore.open_or_build(corpus)
+            names = [contacts[i]['full_name'] for i in sorted(watched) + planned]
+            matcher, status = BigramMatcher.load_or_compile(
+                store, (matcher_key(contact['full_name']) for contact in contacts))
+            matches = match_contacts_bigram(store, matcher, names)
+            print(f"Matched {len(matches):,} connections ({status} matcher) against "
+                  f"{store.token_count:,} tokens in {time.perf_counter() - started:.2f}s")
+
+            def backend(name):
+                # Names matched up front, or one queued by another process
+                if name in matches:
+                    return matches[name]
+                return search_corpus(corpus, name)
+        elif args.corpus_index:
+            started = time.perf_counter()
+            index, built = SuffixIndex.open_or_build(corpus)
+            if built:
+                print(f"Built suffix index {index.path} in {time.perf_counter() - started:.1f}s")
+            backend = functools.partial(search_suffix_index, index)
+        else:
+            backend = functools.partial(search_corpus, corpus)
+        print(f"Searching local corpus {args.corpus} ({corpus.doc_count:,} documents)")
+        api_key = None
+    else:
+        backend = None
+        if not HAS_REQUESTS:
+            print("Error: 'requests' library is required to search the API. Install with: pip install requests",
+                  file=sys.stderr)
+            sys.exit(1)
 
-    # Build results: fresh searches + cached entries for remaining contacts
+        # Get API key (prompts user if not stored)
+        api_key = get_api_key()
+        print("Searching Epstein files API...")
+
+    if args.queue:
+        print("(Press Ctrl+C to stop and generate a partial report; unfinished jobs stay in the queue)\n")
+    else:
+        print("(Press Ctrl+C to stop and generate a partial report; rerun with --resume to continue)\n")
+
+    request_log = JsonLogWriter(args.log_json) if args.log_json else None
+
+    shutdown = Shutdown(args.shutdown_timeout)
+    shutdown.install()
+    with tracer.span('searches', planned=len(planned)):
+        if args.queue:
+            # Watched contacts go first; the queue has no separate lane
+            queue = WorkQueue(args.queue)
+            seeded = queue.seed(contacts[i] for i in sorted(watched) + planned)
+            if seeded:
+                print(f"Queued {seeded} searches in {args.queue}")
+            else:
+                print(f"Joining the open work in {args.queue}")
+            searched_this_run, search_count = run_queue_worker(
+                queue, cache, api_key, args, shutdown, request_log, tracer, HistoryStore(), backend
+            )
+            watch_changes = []
+        else:
+            searched_this_run, search_count, watch_changes = run_searches(
+                contacts, planned, progress, cache, api_key, args, shutdown, request_log, tracer, watched,
+                HistoryStore(), backend
+            )
+
+    if request_log is not None:
+        request_log.close()
+
+    if args.daily_quota:
+        record_quota_use(search_count)
+
+    if search_count and not hit_dictionary_ids() \
+            and sum(1 for entry in cache.values() if entry.get('total_hits')) >= HITS_DICT_MIN_ENTRIES:
+        with tracer.span('train_hit_dictionary'):
+            codec, trained_cache = train_shared_hit_dictionary()
+        if codec:
+            # Entries in memory may use a dictionary the training replaced
+            cache = trained_cache
+            print(f"Trained a {len(codec.dictionary) // 1024} KB {codec.kind} dictionary for cached hits")
+
+    # Report contacts: fresh searches + cached entries for remaining contacts.
+    # Their hits are clustered while the report is rendered.
     fresh_count = len(searched_this_run)
     cached_count = 0
-    results = []
+    report_contacts = []
+
+    history_series = HistoryStore().series()
 
     for contact in contacts:
         name = contact['full_name']
@@ -477,45 +4091,57 @@ To export your LinkedIn connections:
         else:
             continue
 
-        results.append({
-            'name': name,
-            'first_name': entry['first_name'],
-            'last_name': entry['last_name'],
-            'company': entry['company'],
-            'position': entry['position'],
-            'total_mentions': entry['total_hits'],
-            'hits': entry['hits'],
-        })
+        report_contacts.append((name, entry, history_series.get(name)))
 
     print(f"\n{fresh_count} contacts searched fresh, {cached_count} loaded from cache.")
 
-    if not results:
+    if not report_contacts:
         print("No results collected yet. Exiting without generating report.")
         sys.exit(0)
 
     # Sort by mentions (descending)
-    results.sort(key=lambda x: x['total_mentions'], reverse=True)
+    report_contacts.sort(key=lambda contact: contact[1]['total_hits'], reverse=True)
 
     # Write HTML report
     print(f"\nWriting report to: {args.output}")
-    generate_html_report(results, args.output)
+    with tracer.span('render_report', results=len(report_contacts)):
+        report_paths, results = generate_html_report(report_contacts, args.output, args.compress, args.logo,
+                                                     args.render_workers, watch_changes,
+                                                     dedup=not args.no_dedup)
 
     # Print summary
     contacts_with_mentions = [r for r in results if r['total_mentions'] > 0]
     print(f"\n{'='*60}")
     print("SUMMARY")
     print(f"{'='*60}")
+
+    if watch_changes:
+        print("Watchlist changes:")
+        for name, previous, total in watch_changes:
+            print(f"  {name}: {previous or 0:,} -> {total:,} mentions")
+        print()
+
     print(f"Total connections searched: {len(results)}")
     print(f"Connections with mentions: {len(contacts_with_mentions)}")
 
     if contacts_with_mentions:
         print(f"\nTop mentions:")
         for r in contacts_with_mentions[:20]:
-            print(f"  {r['total_mentions']:6,} - {r['name']}")
+            if r['unique_mentions'] != r['total_mentions']:
+                print(f"  {r['total_mentions']:6,} - {r['name']} ({r['unique_mentions']:,} unique)")
+            else:
+                print(f"  {r['total_mentions']:6,} - {r['name']}")
     else:
         print("\nNo connections found in the Epstein files.")
 
-    print(f"\nFull report saved to: {args.output}")
+    print(f"\nFull report saved to: {', '.join(report_paths)}")
+
+    if shutdown.requested_at is not None:
+        print(f"Interrupt to finished report: {time.monotonic() - shutdown.requested_at:.1f}s")
+
+    if args.trace:
+        tracer.save()
+        print(f"Trace written to: {args.trace}")
 
 
 if __name__ == '__main__':
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""
+Local mock of the Epstein files search API, for development and testing.
+
+Usage:
+    python tools/mock_api.py [--port 8765] [--rate-limit 0.05] [--latency-ms 50]
+
+Then point EpsteOut at it:
+    python EpsteOut.py --connections Connections.csv --api-url http://127.0.0.1:8765/api/v1/search
+
+Results are deterministic per (name, dataset version). Responses carry an
+ETag (a hash of the body) and Last-Modified, and conditional requests
+(If-None-Match / If-Modified-Since) get a 304 when nothing changed.
+POST /admin/release bumps the dataset version, as if new files were
+published, which changes the results for some names. POST /admin/config
+with a JSON body such as {"rate_limit": 0.3, "latency_ms": 400} changes
+rate limiting and latency without a restart.
+"""
+
+import argparse
+from email.utils import formatdate, parsedate_to_datetime
+import hashlib
+from http.server import BaseHTTPRequestHandler, HTTPServer
+import json
+import random
+from socketserver import ThreadingMixIn
+import threading
+import time
+import urllib.parse
+
+SEARCH_PATH = '/api/v1/search'
+
+SNIPPETS = [
+    "Email from {name} regarding the meeting on Tuesday with several guests and the pilot log entries for the weekend.",
+    "Flight manifest lists {name} among passengers departing Teterboro, with a handwritten note about seating.",
+    "Deposition transcript excerpt in which counsel asks whether {name} attended the dinner described in Exhibit 12.",
+    "Contact book entry for {name}, including office and mobile numbers and an address in New York.",
+    "Calendar entry: lunch with {name}, confirmed by assistant, location redacted.",
+]
+
+
+class ThreadingServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+
+class MockState:
+    """Dataset version and request counters shared by handler threads."""
+
+    def __init__(self, options):
+        self.options = options
+        self.version = 1
+        self.released = time.time()
+        self.lock = threading.Lock()
+        self.rng = random.Random(options.seed)
+        self.requests = 0
+        self.rate_limited = 0
+        self.not_modified = 0
+
+    def roll(self):
+        with self.lock:
+            return self.rng.random()
+
+
+def build_results(name, version, hit_rate):
+    """Deterministic results for a name at a dataset version."""
+    rng = random.Random(f"{name}|{version // 3}")
+    if rng.random() >= hit_rate:
+        return 0, []
+
+    # Later releases add documents for some names
+    count = rng.randint(1, 6) + (version if rng.random() < 0.3 else 0)
+    hits = []
+    for i in range(count):
+        dataset = rng.randint(1, 12)
+        doc = rng.randint(1, 99999)
+        snippet = rng.choice(SNIPPETS).format(name=name)
+        if rng.random() < 0.3:
+            # Same document in another production, re-OCR'd
+            snippet = snippet.replace('the', 'tbe', 1)
+        hits.append({
+            'content_preview': snippet,
+            'content': snippet * 20,
+            'file_path': f"/dataset{dataset}/EFTA{doc:08d}.pdf",
+            'score': round(rng.random(), 4),
+        })
+
+    return count * rng.randint(1, 4), hits
+
+
+class Handler(BaseHTTPRequestHandler):
+    state = None
+
+    def log_message(self, format, *args):
+        if self.state.options.verbose:
+            super().log_message(format, *args)
+
+    def send_json(self, status, payload, extra_headers=()):
+        body = json.dumps(payload).encode('utf-8')
+        self.send_response(status)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        for key, value in extra_headers:
+            self.send_header(key, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_POST(self):
+        state = self.state
+        if self.path == '/admin/release':
+            with state.lock:
+                state.version += 1
+                state.released = time.time()
+            self.send_json(200, {'version': state.version})
+        elif self.path == '/admin/config':
+            # Change the rate limiting and latency of a running server
+            length = int(self.headers.get('Content-Length', 0))
+            try:
+                changes = json.loads(self.rfile.read(length) or b'{}')
+            except ValueError:
+                self.send_json(400, {'success': False, 'error': 'invalid JSON'})
+                return
+            with state.lock:
+                for key in ('rate_limit', 'retry_after', 'latency_ms'):
+                    if key in changes:
+                        setattr(state.options, key, type(getattr(state.options, key))(changes[key]))
+            self.send_json(200, {key: getattr(state.options, key) for key in ('rate_limit', 'retry_after', 'latency_ms')})
+        else:
+            self.send_json(404, {'success': False, 'error': 'not found'})
+
+    def do_GET(self):
+        state = self.state
+        options = state.options
+        parsed = urllib.parse.urlparse(self.path)
+
+        if parsed.path == '/admin/stats':
+            self.send_json(200, {
+                'version': state.version,
+                'requests': state.requests,
+                'rate_limited': state.rate_limited,
+                'not_modified': state.not_modified,
+            })
+            return
+
+        if parsed.path != SEARCH_PATH:
+            self.send_json(404, {'success': False, 'error': 'not found'})
+            return
+
+        with state.lock:
+            state.requests += 1
+
+        if not self.headers.get('Authorization', '').startswith('Bearer '):
+            self.send_json(401, {'success': False, 'error': 'missing API key'})
+            return
+
+        if options.latency_ms:
+            time.sleep(min(random.expovariate(1000.0 / options.latency_ms), 10 * options.latency_ms / 1000.0))
+
+        if state.roll() < options.rate_limit:
+            with state.lock:
+                state.rate_limited += 1
+            self.send_json(429, {'success': False, 'error': 'rate limited'},
+                           [('Retry-After', str(options.retry_after))])
+            return
+
+        query = urllib.parse.parse_qs(parsed.query).get('q', [''])[0].strip('"')
+        total_hits, hits = build_results(query, state.version, options.hit_rate)
+        payload = {'success': True, 'data': {'totalHits': total_hits, 'hits': hits}}
+        body = json.dumps(payload, sort_keys=True).encode('utf-8')
+
+        etag = '"' + hashlib.sha256(body).hexdigest()[:32] + '"'
+        last_modified = formatdate(state.released, usegmt=True)
+        validators = [('ETag', etag), ('Last-Modified', last_modified)]
+
+        if_none_match = self.headers.get('If-None-Match')
+        if_modified_since = self.headers.get('If-Modified-Since')
+        unchanged = False
+        if if_none_match is not None:
+            unchanged = etag in [tag.strip() for tag in if_none_match.split(',')]
+        elif if_modified_since is not None:
+            try:
+                unchanged = parsedate_to_datetime(if_modified_since).timestamp() >= int(state.released)
+            except (TypeError, ValueError):
+                unchanged = False
+
+        if unchanged:
+            with state.lock:
+                state.not_modified += 1
+            self.send_response(304)
+            for key, value in validators:
+                self.send_header(key, value)
+            self.end_headers()
+            return
+
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        for key, value in validators:
+            self.send_header(key, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Local mock of the Epstein files search API')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--port', type=int, default=8765)
+    parser.add_argument('--hit-rate', type=float, default=0.3,
+                        help='Fraction of names with any hits (default: 0.3)')
+    parser.add_argument('--rate-limit', type=float, default=0.0,
+                        help='Probability that a request gets a 429 (default: 0)')
+    parser.add_argument('--retry-after', type=int, default=1,
+                        help='Retry-After seconds sent with 429 responses (default: 1)')
+    parser.add_argument('--latency-ms', type=float, default=0.0,
+                        help='Mean added response latency in milliseconds (default: 0)')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--verbose', action='store_true', help='Log every request')
+    options = parser.parse_args()
+
+    Handler.state = MockState(options)
+    server = ThreadingServer((options.host, options.port), Handler)
+    print(f"Mock API listening on http://{options.host}:{server.server_port}{SEARCH_PATH}", flush=True)
+
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,353 @@
+#!/usr/bin/env python3
+"""
+Long-running soak test of the search pipeline against tools/mock_api.py.
+
+Usage:
+    python tools/soak.py [--duration 4h] [--contacts 500] [--churn 0.1] [--workers 4]
+
+Starts a mock API server and runs EpsteOut's full refresh (search, cache,
+history, report) over and over in this process, so leaks accumulate the
+way they would in a long-lived one. Between cycles the contact list is
+churned and the mock cycles through traffic patterns: steady, 429 bursts,
+slow responses and new document releases.
+
+After every cycle it samples RSS, open file descriptors, threads, cache
+size per contact and requests per second, optionally writing them to
+--samples as CSV. At the end, a least-squares trend is fitted to each
+metric after the warmup cycles; the run fails (exit status 1) if memory,
+file descriptors, threads or cache size per contact grew, or throughput
+fell, past the thresholds.
+"""
+
+import argparse
+import contextlib
+import csv
+import gc
+import importlib.util
+import io
+import json
+import os
+import random
+import re
+import signal
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+import urllib.request
+
+REPO_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Traffic patterns the mock cycles through, one per refresh
+PHASES = [
+    ('steady', {'rate_limit': 0.02, 'retry_after': 1, 'latency_ms': 50}),
+    ('429 burst', {'rate_limit': 0.3, 'retry_after': 1, 'latency_ms': 50}),
+    ('slow', {'rate_limit': 0.02, 'retry_after': 1, 'latency_ms': 400}),
+    ('release', {'rate_limit': 0.05, 'retry_after': 1, 'latency_ms': 100}),
+]
+
+FIRST_NAMES = ['Alice', 'Bob', 'Carol', 'Dan', 'Eve', 'Frank', 'Grace', 'Heidi', 'Ivan', 'Judy',
+               'Mallory', 'Niaj', 'Olivia', 'Peggy', 'Rupert', 'Sybil', 'Trent', 'Victor', 'Walter']
+LAST_NAMES = ['Smith', 'Jones', 'Brown', 'King', 'Clark', 'Lewis', 'Young', 'Hall', 'Allen', 'Wright']
+
+
+def parse_duration(text):
+    """Seconds in a duration like '90s', '30m', '4h' or a plain number of seconds."""
+    match = re.fullmatch(r'(\d+(?:\.\d+)?)([smh]?)', text.strip())
+    if not match:
+        raise argparse.ArgumentTypeError(f"invalid duration: {text}")
+    return float(match.group(1)) * {'': 1, 's': 1, 'm': 60, 'h': 3600}[match.group(2)]
+
+
+def rss_bytes():
+    """Current resident set size, or None where it can't be read."""
+    try:
+        with open('/proc/self/statm') as f:
+            return int(f.read().split()[1]) * os.sysconf('SC_PAGE_SIZE')
+    except (OSError, ValueError, AttributeError):
+        pass
+    try:
+        import resource
+        peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+        return peak if sys.platform == 'darwin' else peak * 1024  # Peak, not current
+    except ImportError:
+        return None
+
+
+def open_fds():
+    for fd_dir in ('/proc/self/fd', '/dev/fd'):
+        if os.path.isdir(fd_dir):
+            return len(os.listdir(fd_dir))
+    return None
+
+
+def slope(xs, ys):
+    """Least-squares slope of ys over xs."""
+    n = len(xs)
+    mean_x, mean_y = sum(xs) / n, sum(ys) / n
+    variance = sum((x - mean_x) ** 2 for x in xs)
+    if not variance:
+        return 0.0
+    return sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, ys)) / variance
+
+
+class MockServer:
+    """tools/mock_api.py running in a subprocess on a free port."""
+
+    def __init__(self, hit_rate):
+        self.process = subprocess.Popen(
+            [sys.executable, os.path.join(REPO_DIR, 'tools', 'mock_api.py'), '--port', '0',
+             '--hit-rate', str(hit_rate)],
+            stdout=subprocess.PIPE, text=True
+        )
+        line = self.process.stdout.readline()
+        match = re.search(r'http://[\d.]+:(\d+)', line)
+        if not match:
+            self.process.kill()
+            raise RuntimeError(f"Mock API failed to start: {line!r}")
+        self.base_url = f"http://127.0.0.1:{match.group(1)}"
+        self.search_url = self.base_url + '/api/v1/search'
+
+    def admin(self, path, payload=None):
+        data = json.dumps(payload).encode('utf-8') if payload is not None else None
+        method = 'GET' if path == '/admin/stats' else 'POST'
+        request = urllib.request.Request(self.base_url + path, data=data, method=method,
+                                         headers={'Content-Type': 'application/json'})
+        with urllib.request.urlopen(request, timeout=10) as response:
+            return json.loads(response.read())
+
+    def stop(self):
+        self.process.terminate()
+        self.process.wait(timeout=10)
+
+
+class ContactList:
+    """A Connections.csv whose members are partly replaced every cycle."""
+
+    def __init__(self, path, size, seed):
+        self.path = path
+        self.rng = random.Random(seed)
+        self.serial = 0
+        self.contacts = [self._new_contact() for _ in range(size)]
+
+    def _new_contact(self):
+        self.serial += 1
+        return (self.rng.choice(FIRST_NAMES), f"{self.rng.choice(LAST_NAMES)}{self.serial}")
+
+    def churn(self, fraction):
+        for i in self.rng.sample(range(len(self.contacts)), int(len(self.contacts) * fraction)):
+            self.contacts[i] = self._new_contact()
+
+    def write(self):
+        with open(self.path, 'w', encoding='utf-8', newline='') as f:
+            f.write('Notes:\n"Generated by tools/soak.py"\n\n')
+            writer = csv.writer(f)
+            writer.writerow(['First Name', 'Last Name', 'URL', 'Email Address', 'Company', 'Position',
+                             'Connected On'])
+            for first, last in self.contacts:
+                writer.writerow([first, last, '', '', 'Soak Co', 'Tester', '01 Jan 2020'])
+
+
+def soak_shutdown(shutdown_class):
+    """
+    EpsteOut's Ctrl+C handling, adapted for the harness. A first Ctrl+C
+    still lets the current cycle finish, and is remembered so the soak
+    stops after it. A second raises KeyboardInterrupt instead of exiting
+    the process, so the mock is stopped and the cycles so far are judged.
+    """
+    class SoakShutdown(shutdown_class):
+        interrupted = False
+
+        def _handle(self, signum, frame):
+            if self.stop_event.is_set():
+                raise KeyboardInterrupt
+            SoakShutdown.interrupted = True
+            print("\nInterrupted; finishing this cycle (Ctrl+C again to stop now).", file=sys.__stdout__, flush=True)
+            super()._handle(signum, frame)
+
+    return SoakShutdown
+
+
+def load_epsteout(workdir):
+    """Import EpsteOut with workdir as its working directory, where it keeps its state files."""
+    os.chdir(workdir)
+    spec = importlib.util.spec_from_file_location('EpsteOut', os.path.join(REPO_DIR, 'EpsteOut.py'))
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    # Refresh every contact on every cycle instead of once a day
+    module.CACHE_TTL_HOURS = 0
+    module.Shutdown = soak_shutdown(module.Shutdown)
+    return module
+
+
+def run_cycle(epsteout, argv):
+    """
+    Run one full refresh, returning its output. EpsteOut's Ctrl+C handler
+    is only in place during the refresh; a Ctrl+C during it raises
+    KeyboardInterrupt once the refresh is done.
+    """
+    output = io.StringIO()
+    saved_argv = sys.argv
+    saved_handler = signal.getsignal(signal.SIGINT)
+    sys.argv = ['EpsteOut.py'] + argv
+    try:
+        with contextlib.redirect_stdout(output), contextlib.redirect_stderr(output):
+            epsteout.main()
+    except SystemExit as e:
+        if e.code not in (None, 0):
+            raise RuntimeError(f"EpsteOut exited with status {e.code}:\n{output.getvalue()[-2000:]}")
+    finally:
+        sys.argv = saved_argv
+        signal.signal(signal.SIGINT, saved_handler)
+    if epsteout.Shutdown.interrupted:
+        raise KeyboardInterrupt
+    return output.getvalue()
+
+
+def check_trends(samples, options):
+    """Return the failed checks, as messages, for the samples after warmup."""
+    measured = samples[options.warmup:]
+    if len(measured) < 3:
+        return ["Too few cycles after warmup to judge trends; run longer or lower --warmup"]
+
+    times = [s['elapsed'] for s in measured]
+    span = times[-1] - times[0]
+    failures = []
+
+    def growth(key):
+        values = [s[key] for s in measured]
+        if any(v is None for v in values):
+            return None
+        return slope(times, values) * span
+
+    checks = [
+        ('rss_mb', options.max_rss_growth_mb, 'MB of RSS'),
+        ('fds', options.max_fd_growth, 'open file descriptors'),
+        ('threads', options.max_thread_growth, 'threads'),
+        ('bytes_per_contact', options.max_cache_growth * measured[0]['bytes_per_contact'], 'cache bytes per contact'),
+    ]
+    for key, limit, label in checks:
+        grown = growth(key)
+        if grown is not None and grown > limit:
+            failures.append(f"{label} trended up by {grown:,.1f} over the run (limit {limit:,.1f})")
+
+    fallen = -growth('requests_per_second')
+    first_rate = sum(s['requests_per_second'] for s in measured[:3]) / 3
+    if first_rate and fallen > options.max_throughput_drop * first_rate:
+        failures.append(f"throughput trended down by {fallen:,.2f} requests/s from {first_rate:,.2f} "
+                        f"(limit {options.max_throughput_drop:.0%})")
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Soak-test the search pipeline against the mock API')
+    parser.add_argument('--duration', type=parse_duration, default=parse_duration('1h'),
+                        help='How long to run, e.g. 30m or 4h (default: 1h)')
+    parser.add_argument('--contacts', type=int, default=300, help='Size of the contact list (default: 300)')
+    parser.add_argument('--churn', type=float, default=0.1,
+                        help='Fraction of contacts replaced each cycle (default: 0.1)')
+    parser.add_argument('--workers', type=int, default=4, help='EpsteOut --workers (default: 4)')
+    parser.add_argument('--hit-rate', type=float, default=0.3, help='Mock --hit-rate (default: 0.3)')
+    parser.add_argument('--warmup', type=int, default=3, help='Cycles left out of the trends (default: 3)')
+    parser.add_argument('--workdir', help='Directory for the cache and reports (default: a temporary one)')
+    parser.add_argument('--samples', help='Write one CSV row of metrics per cycle to this file')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--max-rss-growth-mb', type=float, default=50.0)
+    parser.add_argument('--max-fd-growth', type=float, default=5.0)
+    parser.add_argument('--max-thread-growth', type=float, default=2.0)
+    parser.add_argument('--max-cache-growth', type=float, default=0.1,
+                        help='Allowed growth of cache bytes per contact, as a fraction (default: 0.1)')
+    parser.add_argument('--max-throughput-drop', type=float, default=0.5,
+                        help='Allowed fall in requests/s, as a fraction (default: 0.5)')
+    options = parser.parse_args()
+
+    workdir = os.path.abspath(options.workdir or tempfile.mkdtemp(prefix='epsteout-soak-'))
+    os.makedirs(workdir, exist_ok=True)
+    with open(os.path.join(workdir, '.epstein_api_key'), 'w') as f:
+        f.write('soak-test-key')
+
+    mock = MockServer(options.hit_rate)
+    epsteout = load_epsteout(workdir)
+    contacts = ContactList(os.path.join(workdir, 'Connections.csv'), options.contacts, options.seed)
+    argv = ['--connections', contacts.path, '--output', 'report.html', '--api-url', mock.search_url,
+            '--workers', str(options.workers), '--logo', 'none']
+
+    print(f"Soak test for {options.duration / 3600:.2f}h in {workdir} against {mock.search_url}")
+    print(f"{'cycle':>5} {'phase':<10} {'secs':>6} {'RSS MB':>7} {'fds':>4} {'thr':>4} "
+          f"{'cache KB':>9} {'B/contact':>9} {'req/s':>6} {'429s':>5}")
+
+    samples = []
+    sample_file = open(options.samples, 'w', newline='') if options.samples else None
+    sample_writer = None
+    started = time.monotonic()
+    previous_stats = mock.admin('/admin/stats')
+
+    try:
+        cycle = 0
+        while time.monotonic() - started < options.duration:
+            phase, config = PHASES[cycle % len(PHASES)]
+            mock.admin('/admin/config', config)
+            if phase == 'release':
+                mock.admin('/admin/release')
+            if cycle:
+                contacts.churn(options.churn)
+            contacts.write()
+
+            cycle_started = time.monotonic()
+            run_cycle(epsteout, argv)
+            seconds = time.monotonic() - cycle_started
+
+            gc.collect()
+            stats = mock.admin('/admin/stats')
+            requests = stats['requests'] - previous_stats['requests']
+            cache_bytes = os.path.getsize(epsteout.CACHE_PATH) if os.path.exists(epsteout.CACHE_PATH) else 0
+            with open(epsteout.CACHE_PATH, 'rb') as f:
+                cache_entries = len(json.loads(f.read()))
+            rss = rss_bytes()
+
+            sample = {
+                'cycle': cycle,
+                'phase': phase,
+                'elapsed': round(time.monotonic() - started, 1),
+                'seconds': round(seconds, 2),
+                'rss_mb': round(rss / 1e6, 1) if rss is not None else None,
+                'fds': open_fds(),
+                'threads': threading.active_count(),
+                'cache_bytes': cache_bytes,
+                'bytes_per_contact': round(cache_bytes / max(cache_entries, 1), 1),
+                'requests_per_second': round(requests / seconds, 2),
+                'rate_limited': stats['rate_limited'] - previous_stats['rate_limited'],
+            }
+            previous_stats = stats
+            samples.append(sample)
+
+            if sample_file:
+                if sample_writer is None:
+                    sample_writer = csv.DictWriter(sample_file, fieldnames=list(sample))
+                    sample_writer.writeheader()
+                sample_writer.writerow(sample)
+                sample_file.flush()
+
+            print(f"{cycle:>5} {phase:<10} {seconds:>6.1f} {sample['rss_mb'] or 0:>7.1f} {sample['fds'] or 0:>4} "
+                  f"{sample['threads']:>4} {cache_bytes / 1024:>9.0f} {sample['bytes_per_contact']:>9.0f} "
+                  f"{sample['requests_per_second']:>6.1f} {sample['rate_limited']:>5}", flush=True)
+            cycle += 1
+    except KeyboardInterrupt:
+        print("\nInterrupted; judging the cycles so far.")
+    finally:
+        mock.stop()
+        if sample_file:
+            sample_file.close()
+
+    failures = check_trends(samples, options)
+    if failures:
+        print("\nFAILED:")
+        for failure in failures:
+            print(f"  - {failure}")
+        sys.exit(1)
+    print(f"\nPASSED: {len(samples)} cycles with no upward trends past the thresholds.")
+
+
+if __name__ == '__main__':
+    main()